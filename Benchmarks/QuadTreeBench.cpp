@@ -0,0 +1,526 @@
+/***************************************
+Benchmark for the spatial indexes. Runs
+a simulated game against each of them:
+clustered food, players moving around,
+split bursts, ejected streams, and the
+viewBox and collision queries the game
+makes every tick. Reports ns per call,
+heap used by the index and tree shape
+***************************************/
+
+#include "../Modules/QuadTree.hpp"
+#include "../Modules/ArenaQuadTree.hpp"
+#include "../Modules/SpatialGrid.hpp"
+#include "../Modules/PartitionedIndex.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+//********************* HEAP ACCOUNTING *********************//
+
+// Bytes currently allocated through operator new. Every allocation is
+// prefixed with its size, keeping the 16 byte alignment malloc gives
+static size_t liveBytes = 0;
+static constexpr size_t HEADER = 16;
+
+void *operator new(size_t size) {
+    void *block = std::malloc(size + HEADER);
+    if (block == nullptr) throw std::bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    liveBytes += size;
+    return static_cast<char*>(block) + HEADER;
+}
+void operator delete(void *ptr) noexcept {
+    if (ptr == nullptr) return;
+    void *block = static_cast<char*>(ptr) - HEADER;
+    liveBytes -= *static_cast<size_t*>(block);
+    std::free(block);
+}
+void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+//********************* OPTIONS *********************//
+
+struct Options {
+    std::vector<std::string> indexes = { "quadTree", "arenaQuadTree", "grid", "partitioned" };
+    std::vector<unsigned> counts     = { 10000, 100000, 1000000 };
+    unsigned capacity  = 64;  // game.quadTreeLeafCapacity
+    unsigned maxDepth  = 32;  // game.quadTreeMaxDepth
+    double   looseness = 1;   // game.quadTreeLooseness
+    double   cellSize  = 512; // game.gridCellSize
+    unsigned ticks     = 100;
+    unsigned seed      = 1;
+};
+
+static void printUsage() {
+    std::printf(
+        "Usage: quadtree_bench [options] [entity counts...]\n"
+        "  --index NAME     quadTree, arenaQuadTree, grid, partitioned or all (default all)\n"
+        "  --capacity N     leaf capacity (default 64)\n"
+        "  --depth N        maximum depth (default 32)\n"
+        "  --looseness X    quadtree looseness (default 1)\n"
+        "  --cell X         grid cell size (default 512)\n"
+        "  --ticks N        simulated ticks (default 100)\n"
+        "  --seed N         random seed (default 1)\n"
+        "Entity counts default to 10000 100000 1000000. The map grows with the\n"
+        "count so that 10000 entities are as dense as a default game.\n");
+}
+
+static bool parseOptions(int argc, char **argv, Options &options) {
+    bool countsGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg == "--index" && hasValue) {
+            std::string name = argv[++i];
+            if (name != "all") options.indexes = { name };
+        } else if (arg == "--capacity" && hasValue) {
+            options.capacity = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--depth" && hasValue) {
+            options.maxDepth = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--looseness" && hasValue) {
+            options.looseness = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--cell" && hasValue) {
+            options.cellSize = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--ticks" && hasValue) {
+            options.ticks = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        } else if (!arg.empty() && arg[0] != '-') {
+            if (!countsGiven) options.counts.clear();
+            countsGiven = true;
+            options.counts.push_back((unsigned)std::strtoul(arg.c_str(), nullptr, 10));
+        } else {
+            std::printf("Unknown option '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    for (const std::string &name : options.indexes) {
+        if (name != "quadTree" && name != "arenaQuadTree" && name != "grid" && name != "partitioned") {
+            std::printf("Unknown index '%s'\n", name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// CellTypeFlags values, without pulling in the game's headers
+static constexpr unsigned char FOOD = 0x02, VIRUS = 0x04, EJECTED = 0x08, PLAYERCELL = 0x20;
+
+static std::unique_ptr<SpatialIndex> makeIndex(const std::string &name, const Rect &bounds, const Options &options) {
+    if (name == "arenaQuadTree")
+        return std::make_unique<ArenaQuadTree>(bounds, options.capacity, options.maxDepth, options.looseness);
+    if (name == "grid")
+        return std::make_unique<SpatialGrid>(bounds, options.cellSize);
+    if (name == "partitioned") {
+        // As the map sets it up by default: two quadtrees, food and viruses
+        // (there are no mothercells here) apart from movers
+        return std::make_unique<PartitionedIndex>(
+            std::make_unique<QuadTree>(bounds, options.capacity, options.maxDepth, options.looseness),
+            std::make_unique<QuadTree>(bounds, options.capacity, options.maxDepth, options.looseness),
+            FOOD | VIRUS);
+    }
+    return std::make_unique<QuadTree>(bounds, options.capacity, options.maxDepth, options.looseness);
+}
+
+//********************* WORKLOAD *********************//
+
+static constexpr double DEFAULT_MAP_SIZE = 14142.135623730952;
+static constexpr double VIEW_WIDTH = 1920, VIEW_HEIGHT = 1080;
+static constexpr unsigned MAX_CELLS = 16;    // player.maxCells
+static constexpr unsigned SPLIT_TICKS = 10;  // Ticks a split cell flies for
+static constexpr unsigned MERGE_TICKS = 50;  // Ticks until a split cell merges back
+static constexpr unsigned EJECT_TICKS = 20;  // Ticks ejected mass flies for
+static constexpr unsigned STREAM_LENGTH = 8; // Ejected per stream, one per tick
+
+struct Player {
+    double x = 0, y = 0;
+    double heading = 0;
+    std::vector<unsigned> cells;  // Slots of its cells, the first one never splits off
+    std::vector<unsigned> merges; // Tick each split cell merges back, parallel to cells
+    unsigned streaming = 0;       // Ejected left to shoot
+};
+
+// Object moving in a straight line while slowing down
+struct Mover {
+    unsigned slot;
+    double   vx, vy;
+    unsigned ticksLeft;
+    bool     ejected;
+    bool     fresh; // Spawned this tick, so inserted rather than updated
+};
+
+// Simulated game the index is driven by. Objects live in a fixed pool,
+// so that their heap use is not counted as the index's
+class Simulation {
+public:
+    Simulation(unsigned count, unsigned seed);
+
+    double mapSize = 0;
+    Rect   bounds;
+
+    std::unique_ptr<Collidable[]> pool;
+    std::vector<unsigned> freeSlots;
+    std::vector<unsigned> spawned;  // Slots the index has not been given yet
+    std::vector<unsigned> food;     // Food slots, for eating
+    std::deque<unsigned>  resting;  // Ejected at rest, oldest first
+    std::vector<Player>   players;
+    std::vector<Mover>    movers;
+    std::mt19937          rng;
+
+    // What the next tick does to the index, worked out before timing it
+    std::vector<unsigned> toUpdate, toRemove, toInsert;
+
+    void plan(unsigned tick);
+    Rect viewBox(const Player &player) const;
+
+private:
+    std::vector<std::pair<double, double>> clusters;
+
+    unsigned allocate(double x, double y, double radius, unsigned char flag);
+    double uniform(double min, double max);
+    void clamp(double &x, double &y) const;
+    void spawnFood();
+};
+
+Simulation::Simulation(unsigned count, unsigned seed) :
+    rng(seed) {
+    // Same density as a default game at 10k entities
+    mapSize = DEFAULT_MAP_SIZE * std::sqrt(std::max(count, 1u) / 10000.0);
+    bounds = Rect(0, 0, mapSize, mapSize);
+
+    unsigned playerCells = count * 6 / 100;
+    unsigned ejected     = count * 4 / 100;
+    unsigned viruses     = count * 2 / 100;
+    unsigned foods       = count - playerCells - ejected - viruses;
+    unsigned playerCount = std::max(1u, playerCells / 8);
+
+    // Room for split cells on top of everything spawned now
+    unsigned capacity = count + playerCount * MAX_CELLS;
+    pool.reset(new Collidable[capacity]);
+    for (unsigned slot = capacity; slot > 0; --slot)
+        freeSlots.push_back(slot - 1);
+
+    for (unsigned i = 0, n = std::max(1u, foods / 500); i < n; ++i)
+        clusters.emplace_back(uniform(-mapSize / 2, mapSize / 2), uniform(-mapSize / 2, mapSize / 2));
+    for (unsigned i = 0; i < foods; ++i)
+        spawnFood();
+    for (unsigned i = 0; i < viruses; ++i)
+        spawned.push_back(allocate(uniform(-mapSize / 2, mapSize / 2), uniform(-mapSize / 2, mapSize / 2), 100, VIRUS));
+
+    // Players start with 8 cells each around their center, mostly small with a few huge ones
+    std::exponential_distribution<double> size(1 / 60.0);
+    players.resize(playerCount);
+    for (unsigned i = 0; i < playerCells; ++i) {
+        Player &player = players[i % playerCount];
+        if (player.cells.empty()) {
+            player.x = uniform(-mapSize / 2, mapSize / 2);
+            player.y = uniform(-mapSize / 2, mapSize / 2);
+            player.heading = uniform(0, 6.283185307179586);
+        }
+        double x = player.x + uniform(-300, 300), y = player.y + uniform(-300, 300);
+        clamp(x, y);
+        unsigned slot = allocate(x, y, std::min(32 + size(rng), 1500.0), PLAYERCELL);
+        player.cells.push_back(slot);
+        player.merges.push_back(1 + rng() % MERGE_TICKS); // As if they had split a moment ago
+        spawned.push_back(slot);
+    }
+    // Ejected sits in piles near players
+    for (unsigned i = 0; i < ejected; ++i) {
+        const Player &player = players[i % playerCount];
+        double x = player.x + uniform(-800, 800), y = player.y + uniform(-800, 800);
+        clamp(x, y);
+        unsigned slot = allocate(x, y, 42.4264, EJECTED);
+        resting.push_back(slot);
+        spawned.push_back(slot);
+    }
+}
+
+double Simulation::uniform(double min, double max) {
+    return std::uniform_real_distribution<double>(min, max)(rng);
+}
+
+void Simulation::clamp(double &x, double &y) const {
+    x = std::clamp(x, -mapSize / 2, mapSize / 2);
+    y = std::clamp(y, -mapSize / 2, mapSize / 2);
+}
+
+unsigned Simulation::allocate(double x, double y, double radius, unsigned char flag) {
+    unsigned slot = freeSlots.back();
+    freeSlots.pop_back();
+    pool[slot] = Collidable({ x, y, radius * 2, radius * 2 }, nullptr, flag);
+    return slot;
+}
+
+// 70% of food is clustered, the rest is spread evenly
+void Simulation::spawnFood() {
+    double x, y;
+    if (uniform(0, 1) < 0.7) {
+        const std::pair<double, double> &center = clusters[rng() % clusters.size()];
+        std::normal_distribution<double> spread(0, mapSize / 40);
+        x = center.first + spread(rng);
+        y = center.second + spread(rng);
+        clamp(x, y);
+    } else {
+        x = uniform(-mapSize / 2, mapSize / 2);
+        y = uniform(-mapSize / 2, mapSize / 2);
+    }
+    unsigned slot = allocate(x, y, uniform(10, 20), FOOD);
+    food.push_back(slot);
+    spawned.push_back(slot);
+}
+
+// Moves everything for one tick and lists the index calls that follow from it
+void Simulation::plan(unsigned tick) {
+    toUpdate.clear();
+    toRemove.clear();
+    toInsert.clear();
+
+    for (Player &player : players) {
+        // Wander, turning around at the edges
+        player.heading += uniform(-0.2, 0.2);
+        double dx = std::cos(player.heading) * 25, dy = std::sin(player.heading) * 25;
+        if (std::abs(player.x + dx) > mapSize / 2 || std::abs(player.y + dy) > mapSize / 2) {
+            player.heading += 3.141592653589793;
+            dx = -dx;
+            dy = -dy;
+        }
+        player.x += dx;
+        player.y += dy;
+
+        // Merge split cells back into the first one
+        for (unsigned i = 1; i < player.cells.size();) {
+            if (player.merges[i] > tick) {
+                ++i;
+                continue;
+            }
+            Rect &main = pool[player.cells[0]].bound;
+            double width = std::hypot(main.width(), pool[player.cells[i]].bound.width());
+            main.setSize(width, width);
+            toRemove.push_back(player.cells[i]);
+            player.cells[i] = player.cells.back();
+            player.merges[i] = player.merges.back();
+            player.cells.pop_back();
+            player.merges.pop_back();
+        }
+        // Every cell drifts along with the player
+        for (unsigned slot : player.cells) {
+            Rect &bound = pool[slot].bound;
+            double x = bound.x() + dx + uniform(-3, 3), y = bound.y() + dy + uniform(-3, 3);
+            clamp(x, y);
+            bound.setPosition(x, y);
+            toUpdate.push_back(slot);
+        }
+        // Split burst: every cell big enough splits towards the heading
+        if (rng() % 200 == 0) {
+            for (unsigned i = 0, n = (unsigned)player.cells.size(); i < n && player.cells.size() < MAX_CELLS; ++i) {
+                Rect &bound = pool[player.cells[i]].bound;
+                if (bound.width() < 2 * 60) continue;
+                double width = bound.width() * 0.7071067811865476;
+                bound.setSize(width, width);
+                unsigned slot = allocate(bound.x(), bound.y(), width / 2, PLAYERCELL);
+                player.cells.push_back(slot);
+                player.merges.push_back(tick + MERGE_TICKS);
+                movers.push_back({ slot, std::cos(player.heading) * 90, std::sin(player.heading) * 90, SPLIT_TICKS, false, true });
+                toInsert.push_back(slot);
+            }
+        }
+        // Ejected stream: a few ticks of mass shot towards the heading, replacing the oldest at rest
+        if (player.streaming == 0 && rng() % 100 == 0)
+            player.streaming = STREAM_LENGTH;
+        if (player.streaming > 0 && !resting.empty()) {
+            --player.streaming;
+            const Rect &from = pool[player.cells[0]].bound;
+            double angle = player.heading + uniform(-0.1, 0.1);
+            unsigned slot = allocate(from.x(), from.y(), 42.4264, EJECTED);
+            movers.push_back({ slot, std::cos(angle) * 80, std::sin(angle) * 80, EJECT_TICKS, true, true });
+            toInsert.push_back(slot);
+            toRemove.push_back(resting.front());
+            resting.pop_front();
+        }
+    }
+    // Fly movers, slowing them down until they stop
+    for (unsigned i = 0; i < movers.size();) {
+        Mover &mover = movers[i];
+        Rect &bound = pool[mover.slot].bound;
+        double x = bound.x() + mover.vx, y = bound.y() + mover.vy;
+        clamp(x, y);
+        bound.setPosition(x, y);
+        mover.vx *= 0.85;
+        mover.vy *= 0.85;
+        if (!mover.fresh)
+            toUpdate.push_back(mover.slot);
+        mover.fresh = false;
+        if (--mover.ticksLeft > 0) {
+            ++i;
+            continue;
+        }
+        if (mover.ejected)
+            resting.push_back(mover.slot);
+        movers[i] = movers.back();
+        movers.pop_back();
+    }
+    // Food gets eaten and respawns elsewhere
+    unsigned eaten = std::max(1u, (unsigned)food.size() / 1000);
+    for (unsigned i = 0; i < eaten; ++i) {
+        unsigned index = rng() % food.size();
+        toRemove.push_back(food[index]);
+        food[index] = food.back();
+        food.pop_back();
+    }
+    for (unsigned i = 0; i < eaten; ++i)
+        spawnFood();
+    toInsert.insert(toInsert.end(), spawned.begin(), spawned.end());
+    spawned.clear();
+}
+
+// viewBox of a player, zoomed out the way Player::updateScore() scales it
+Rect Simulation::viewBox(const Player &player) const {
+    double total = 0;
+    for (unsigned slot : player.cells)
+        total += pool[slot].bound.width() / 2;
+    double scale = std::pow(std::min(64.0 / std::max(total, 1.0), 1.0), 0.4);
+    return Rect(player.x, player.y, VIEW_WIDTH / scale, VIEW_HEIGHT / scale);
+}
+
+//********************* MEASUREMENT *********************//
+
+struct Timing {
+    double   seconds = 0;
+    unsigned long long calls = 0;
+    unsigned long long found = 0; // Objects returned, for queries
+
+    void print(const char *name) const {
+        if (calls == 0) return;
+        std::printf("  %-16s %10.1f ns/op  %12llu ops", name, seconds * 1e9 / calls, calls);
+        if (found > 0) std::printf("  %10.1f found/op", (double)found / calls);
+        std::printf("\n");
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+static double since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void run(const std::string &name, unsigned count, const Options &options) {
+    Simulation sim(count, options.seed);
+    std::printf("%s, %u entities (map %.0f x %.0f, capacity %u, depth %u, looseness %g, cell %g)\n",
+        name.c_str(), count, sim.mapSize, sim.mapSize, options.capacity, options.maxDepth, options.looseness, options.cellSize);
+
+    // Heap held by the index: whatever it allocated (net) while being built and modified
+    Timing insert, update, remove, viewBox, collision, removeAll;
+    long long heap = -(long long)liveBytes;
+    std::unique_ptr<SpatialIndex> index = makeIndex(name, sim.bounds, options);
+
+    Clock::time_point start = Clock::now();
+    for (unsigned slot : sim.spawned)
+        index->insert(&sim.pool[slot]);
+    insert.seconds += since(start);
+    insert.calls += sim.spawned.size();
+    sim.spawned.clear();
+    heap += (long long)liveBytes;
+
+    std::vector<Collidable*> found;
+    for (unsigned tick = 1; tick <= options.ticks; ++tick) {
+        index->setEpoch(tick);
+        sim.plan(tick);
+
+        heap -= (long long)liveBytes;
+        start = Clock::now();
+        for (unsigned slot : sim.toRemove)
+            index->remove(&sim.pool[slot]);
+        remove.seconds += since(start);
+        remove.calls += sim.toRemove.size();
+        for (unsigned slot : sim.toRemove)
+            sim.freeSlots.push_back(slot);
+
+        start = Clock::now();
+        for (unsigned slot : sim.toUpdate)
+            index->update(&sim.pool[slot]);
+        update.seconds += since(start);
+        update.calls += sim.toUpdate.size();
+
+        start = Clock::now();
+        for (unsigned slot : sim.toInsert)
+            index->insert(&sim.pool[slot]);
+        insert.seconds += since(start);
+        insert.calls += sim.toInsert.size();
+        heap += (long long)liveBytes;
+
+        // Every player cell looks for what it touches, as map::update() does
+        start = Clock::now();
+        for (const Player &player : sim.players) {
+            for (unsigned slot : player.cells) {
+                found.clear();
+                index->getObjectsInBound(sim.pool[slot].bound, found);
+                collision.found += found.size();
+                ++collision.calls;
+            }
+        }
+        collision.seconds += since(start);
+
+        // Then every player gathers its view
+        start = Clock::now();
+        for (const Player &player : sim.players) {
+            found.clear();
+            index->getObjectsInBound(sim.viewBox(player), found);
+            viewBox.found += found.size();
+            ++viewBox.calls;
+        }
+        viewBox.seconds += since(start);
+    }
+    IndexStats stats;
+    index->collectStats(stats);
+    unsigned objects = index->totalObjects();
+
+    start = Clock::now();
+    index->clear();
+    removeAll.seconds = since(start);
+    removeAll.calls = objects;
+
+    insert.print("insert");
+    update.print("update");
+    remove.print("remove");
+    collision.print("collision query");
+    viewBox.print("viewBox query");
+    removeAll.print("clear");
+
+    unsigned maxDepth = 0;
+    double depthSum = 0;
+    for (unsigned depth = 0; depth < stats.objectsAtDepth.size(); ++depth) {
+        if (stats.objectsAtDepth[depth] > 0) maxDepth = depth;
+        depthSum += (double)depth * stats.objectsAtDepth[depth];
+    }
+    std::printf("  memory           %10.2f MB      %12.1f B/object\n", heap / 1048576.0, objects ? (double)heap / objects : 0.0);
+    std::printf("  nodes %u, max depth %u, mean object depth %.2f\n", stats.nodes, maxDepth, objects ? depthSum / objects : 0.0);
+    std::printf("  objects per depth:");
+    for (unsigned depth = 0; depth <= maxDepth && depth < stats.objectsAtDepth.size(); ++depth)
+        std::printf(" %u:%u", depth, stats.objectsAtDepth[depth]);
+    std::printf("\n\n");
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    for (unsigned count : options.counts) {
+        for (const std::string &name : options.indexes)
+            run(name, count, options);
+    }
+    return 0;
+}
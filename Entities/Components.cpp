@@ -0,0 +1,60 @@
+#include "Components.hpp"
+#include "Entity.hpp"
+
+unsigned Components::size() const noexcept {
+    return (unsigned)entity.size();
+}
+
+void Components::reserve(unsigned count) {
+    x.reserve(count);
+    y.reserve(count);
+    vx.reserve(count);
+    vy.reserve(count);
+    radius.reserve(count);
+    mass.reserve(count);
+    invMass.reserve(count);
+    acceleration.reserve(count);
+    flags.reserve(count);
+    entity.reserve(count);
+}
+
+unsigned Components::add(Entity *owner) {
+    x.push_back(0);
+    y.push_back(0);
+    vx.push_back(1);
+    vy.push_back(0);
+    radius.push_back(0);
+    mass.push_back(0);
+    invMass.push_back(0);
+    acceleration.push_back(0);
+    flags.push_back(0);
+    entity.push_back(owner);
+    return size() - 1;
+}
+
+void Components::remove(unsigned row) noexcept {
+    unsigned last = size() - 1;
+    if (row != last) {
+        x[row]            = x[last];
+        y[row]            = y[last];
+        vx[row]           = vx[last];
+        vy[row]           = vy[last];
+        radius[row]       = radius[last];
+        mass[row]         = mass[last];
+        invMass[row]      = invMass[last];
+        acceleration[row] = acceleration[last];
+        flags[row]        = flags[last];
+        entity[row]       = entity[last];
+        entity[row]->row  = row;
+    }
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    radius.pop_back();
+    mass.pop_back();
+    invMass.pop_back();
+    acceleration.pop_back();
+    flags.pop_back();
+    entity.pop_back();
+}
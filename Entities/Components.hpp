@@ -0,0 +1,33 @@
+/***************************************
+Hot per-entity data of one entity type,
+kept as parallel arrays so per-tick
+systems can walk them linearly. Each
+entity owns one row from its spawn until
+its slot is freed at the end of the tick
+it despawns in. Rows stay packed: the
+last row is moved into a freed one
+***************************************/
+
+#pragma once
+#include <vector>
+
+class Entity;
+
+struct Components {
+    std::vector<double>        x, y;   // Position
+    std::vector<double>        vx, vy; // Direction of movement
+    std::vector<float>         radius;
+    std::vector<float>         mass;
+    std::vector<float>         invMass;
+    std::vector<float>         acceleration;
+    std::vector<unsigned char> flags;  // CellStateFlags
+    std::vector<Entity*>       entity; // Entity owning each row
+
+    unsigned size() const noexcept;
+    void reserve(unsigned count);
+
+    // Appends a zeroed row for owner and returns its index
+    unsigned add(Entity *owner);
+    // Frees a row by moving the last one into it
+    void remove(unsigned row) noexcept;
+};
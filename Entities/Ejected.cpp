@@ -1,15 +1,21 @@
 #include "Ejected.hpp"
+#include "../Game/Map.hpp"
 #include "../Game/Game.hpp" // configs
 
 Ejected::Ejected(const Vec2 &pos, float radius, const Color &color) noexcept :
-    Entity(pos, radius, color) {
+    Entity(pos, radius, color, TYPE) {
 
     flag = ejected;
     canEat = cfg::ejected_canEat;
     avoidSpawningOn = nothing; // Must be able to be spawned near any entity
 
-    if (cfg::ejected_isSpiked)   state |= isSpiked;
-    if (cfg::ejected_isAgitated) state |= isAgitated;
+    if (cfg::ejected_isSpiked)   state() |= isSpiked;
+    if (cfg::ejected_isAgitated) state() |= isAgitated;
+}
+// The cell it was ejected from cannot eat it for about 2 seconds (50 ticks)
+void Ejected::onSpawned() noexcept {
+    state() |= justSpawned;
+    map::schedule(this, Timer::spawnGrace, 51);
 }
 
 Ejected::~Ejected() {
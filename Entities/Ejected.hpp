@@ -6,5 +6,6 @@ public:
     static const int TYPE = 2;
 
     Ejected(const Vec2&, float radius, const Color&) noexcept;
+    void onSpawned() noexcept;
     ~Ejected();
 };
\ No newline at end of file
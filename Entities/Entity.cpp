@@ -11,65 +11,75 @@ void Entity::setOwner(Player *owner) noexcept {
 }
 void Entity::setColor(const Color &color) noexcept {
     _color = color;
-    state |= needsUpdate;
+    map::touch(this); // Its bounds are the same, but clients in view must see it
+    Entity::update();
 }
 void Entity::setPosition(const Vec2 &position, bool validate) noexcept {
-    _position = position;
+    double &x = components->x[row], &y = components->y[row];
+    x = position.x;
+    y = position.y;
 
     // Bounce off of map borders
     if (validate) {
+        double &vx = components->vx[row], &vy = components->vy[row];
         // Validate left
-        const float hr = _radius * 0.5f; // half radius
+        const float hr = components->radius[row] * 0.5f; // half radius
         double maxIndent = map::bounds().left() + hr;
-        if (_position.x <= maxIndent) {
-            _position.x = maxIndent;
-            _velocity.x = -_velocity.x;
+        if (x <= maxIndent) {
+            x = maxIndent;
+            vx = -vx;
         }
         // Validate right
-        if ((maxIndent = map::bounds().right() - hr) < _position.x) {
-            _position.x = maxIndent;
-            _velocity.x = -_velocity.x;
+        if ((maxIndent = map::bounds().right() - hr) < x) {
+            x = maxIndent;
+            vx = -vx;
         }
         // Validate bottom
-        if ((maxIndent = map::bounds().bottom() + hr) > _position.y) {
-            _position.y = maxIndent;
-            _velocity.y = -_velocity.y;
+        if ((maxIndent = map::bounds().bottom() + hr) > y) {
+            y = maxIndent;
+            vy = -vy;
         }
         // Validate top
-        if ((maxIndent = map::bounds().top() - hr) < _position.y) {
-            _position.y = maxIndent;
-            _velocity.y = -_velocity.y;
+        if ((maxIndent = map::bounds().top() - hr) < y) {
+            y = maxIndent;
+            vy = -vy;
         }
     }
-    obj.bound.setPosition(_position.x, _position.y);
+    obj.bound.setPosition(x, y);
+    map::markDirty(this);
     Entity::update();
 }
 void Entity::setVelocity(float acceleration, double angle) noexcept {
-    _acceleration = acceleration;
-    _velocity = {
-        std::cos(angle),
-        std::sin(angle)
-    };
-    map::movingEntities.push_back(shared);
+    components->acceleration[row] = acceleration;
+    components->vx[row] = std::cos(angle);
+    components->vy[row] = std::sin(angle);
+    map::startMoving(this);
 }
 void Entity::setVelocity(float acceleration, Vec2 velocity) noexcept {
-    _acceleration = acceleration;
-    _velocity = velocity;
-    map::movingEntities.push_back(shared);
+    components->acceleration[row] = acceleration;
+    components->vx[row] = velocity.x;
+    components->vy[row] = velocity.y;
+    map::startMoving(this);
 }
 void Entity::setMass(float mass) noexcept {
-    _mass = mass;
-    _invMass = 1.0f / mass;
-    _radius = toRadius(mass);
-    obj.bound.setSize(_radius * 2.0, _radius * 2.0);
+    float radius = toRadius(mass);
+    components->mass[row] = mass;
+    components->invMass[row] = 1.0f / mass;
+    components->radius[row] = radius;
+    obj.bound.setSize(radius * 2.0, radius * 2.0);
+    map::markDirty(this);
     Entity::update();
+    onResized();
 }
 void Entity::setRadius(float radius) noexcept {
-    _radius = radius;
-    _mass = toMass(radius);
-    _invMass = 1.0f / _mass;
-    obj.bound.setSize(_radius * 2.0, _radius * 2.0);
+    float mass = toMass(radius);
+    components->radius[row] = radius;
+    components->mass[row] = mass;
+    components->invMass[row] = 1.0f / mass;
+    obj.bound.setSize(radius * 2.0, radius * 2.0);
+    map::markDirty(this);
     Entity::update();
+    onResized();
 }
 void Entity::setCreator(unsigned int id) noexcept {
     _creatorId = id;
@@ -90,26 +100,27 @@ Player *Entity::owner() const noexcept {
 const Color &Entity::color() const noexcept {
     return _color;
 }
-const Vec2 &Entity::position() const noexcept {
-    return _position;
+Vec2 Entity::position() const noexcept {
+    return { components->x[row], components->y[row] };
 }
-const Vec2 &Entity::velocity() const noexcept {
-    return _velocity;
+Vec2 Entity::velocity() const noexcept {
+    return { components->vx[row], components->vy[row] };
 }
 float Entity::mass() const noexcept {
-    return _mass;
+    return components->mass[row];
 }
 float Entity::radius() const noexcept {
-    return _radius;
+    return components->radius[row];
 }
 float Entity::invMass() const noexcept {
-    return _invMass;
+    return components->invMass[row];
 }
 float Entity::acceleration() const noexcept {
-    return _acceleration;
+    return components->acceleration[row];
 }
 float Entity::radiusSquared() const noexcept {
-    return _radius * _radius;
+    float radius = components->radius[row];
+    return radius * radius;
 }
 unsigned int Entity::nodeId() const noexcept {
     return _nodeId;
@@ -123,27 +134,34 @@ unsigned int Entity::killerId() const noexcept {
 unsigned long long Entity::age() const noexcept {
     return game->tickCount - birthTick;
 }
+unsigned char &Entity::state() noexcept {
+    return components->flags[row];
+}
+unsigned char Entity::state() const noexcept {
+    return components->flags[row];
+}
 
 //************************* MISC *************************//
 
 bool Entity::decelerate() noexcept {
     // decelerate by X units per tick
-    float deceleration = std::round(_acceleration / cfg::entity_decelerationPerTick);
+    float &acceleration = components->acceleration[row];
+    float deceleration = std::round(acceleration / cfg::entity_decelerationPerTick);
     if (deceleration <= cfg::entity_minAcceleration) {
-        _acceleration = 0.0f;
+        acceleration = 0.0f;
         return false;
     }
-    _acceleration -= deceleration;
-    setPosition(_position + _velocity * deceleration, true);
+    acceleration -= deceleration;
+    setPosition(position() + velocity() * deceleration, true);
     return true;
 }
-bool Entity::intersects(e_ptr other) const noexcept {
-    return intersects(other->_position, other->_radius);
+bool Entity::intersects(const Entity *other) const noexcept {
+    return intersects(other->position(), other->radius());
 }
 
 bool Entity::intersects(const Vec2 &pos, float radius) const noexcept {
-    float rs = _radius + radius;
-    return (_position - pos).squared() < (rs * rs);
+    float rs = components->radius[row] + radius;
+    return (position() - pos).squared() < (rs * rs);
 }
 void Entity::move() noexcept {
 }
@@ -153,30 +171,36 @@ void Entity::split(double angle, float radius) noexcept {
 }
 void Entity::autoSplit() noexcept {
 }
+// Marks the entity for clients to be sent again. Changes to its bounds
+// are also marked dirty, for the spatial index to catch up with
 void Entity::update() noexcept {
-    if (!map::quadTree.update(&obj) && game != nullptr) {
-        Logger::error("Entity could not be updated: ", toString());
-        // If removed from quadtree and not re-inserted for ANY reason, re-insert it.
-        if (!map::quadTree.contains(&obj))
-            map::quadTree.insert(&obj);
-    } else {
-        state |= needsUpdate;
+    if (!(state() & needsUpdate)) {
+        state() |= needsUpdate;
+        map::markUpdated(this);
     }
 }
+void Entity::onSpawned() noexcept {
+}
 void Entity::onDespawned() noexcept  {
 }
-void Entity::collideWith(e_ptr other) noexcept {
-    if (!shared || !other || state & isRemoved || other->state & isRemoved || !intersects(other))
+void Entity::onTimer(Timer timer) noexcept {
+    if (timer == Timer::spawnGrace)
+        state() &= ~justSpawned;
+}
+void Entity::onResized() noexcept {
+}
+void Entity::collideWith(Entity *other) noexcept {
+    if (!other || state() & isRemoved || other->state() & isRemoved || !intersects(other))
         return;
 
     // Determine if predator should become prey
-    bool isPredatorSmaller = _radius <= other->radius() * cfg::entity_minEatSizeMult;
+    bool isPredatorSmaller = radius() <= other->radius() * cfg::entity_minEatSizeMult;
 
     // Resolve rigid collisions
     if (type == other->type) {
         // Ejected -> resolve collision immediately
         if (type == Ejected::TYPE) {
-            map::resolveCollision(shared, other);
+            map::resolveCollision(this, other);
             // Set velocity again to start chain reaction
             if (other->acceleration() == 0.0f)
                 other->setVelocity(5.125f, position().angle());
@@ -184,11 +208,11 @@ void Entity::collideWith(e_ptr other) noexcept {
         }
         // Playercells from same owner
         else if (_creatorId == other->creator()) {
-            if (!(state & ignoreCollision) || !(other->state & ignoreCollision)) {
+            if (!(state() & ignoreCollision) || !(other->state() & ignoreCollision)) {
                 // Just split -> resolve collision after 15 ticks
                 if (age() > cfg::player_collisionIgnoreTime &&
                     other->age() > cfg::player_collisionIgnoreTime) {
-                    map::resolveCollision(shared, other);
+                    map::resolveCollision(this, other);
                     return;
                 }
                 return; // Merging -> do not eat or resolve collision
@@ -203,25 +227,25 @@ void Entity::collideWith(e_ptr other) noexcept {
             return;
     }
     // Resolve eat collisions
-    e_ptr predator = shared;
-    e_ptr prey = other;
+    Entity *predator = this;
+    Entity *prey = other;
     if (isPredatorSmaller) {
         predator = prey;
-        prey = shared;
+        prey = this;
     }
     // Not allowed to eat or is already removed
-    if (!(predator->canEat & prey->flag) || prey->state & isRemoved)
+    if (!(predator->canEat & prey->flag) || prey->state() & isRemoved)
         return;
     // https://gist.github.com/Megabyte918/0b921e69f9d84b3ea7b8fdebef4f6812#file-gameconfiguration-json-L178
     // assuming "percentageOfCellToSquash" is the range required to eat another cell
-    float range = predator->_radius - cfg::entity_minEatOverlap * prey->_radius;
-    if ((predator->_position - prey->_position).squared() >= range * range)
+    float range = predator->radius() - cfg::entity_minEatOverlap * prey->radius();
+    if ((predator->position() - prey->position()).squared() >= range * range)
         return; // Not close enough to eat
     predator->consume(prey);
 }
-void Entity::consume(e_ptr prey) noexcept {
+void Entity::consume(Entity *prey) noexcept {
     prey->setKiller(_nodeId); // prey was killed by this
-    setMass(_mass + prey->_mass); // add prey's mass to this
+    setMass(mass() + prey->mass()); // add prey's mass to this
     map::despawn(prey); // remove prey from map
 }
 // debugging purposes
@@ -233,21 +257,23 @@ std::string Entity::toString() noexcept {
         << "\ncanEat: " << +canEat
         << "\navoidSpawningOn: " << +avoidSpawningOn
 
-        << "\nisSpiked: " << (state & isSpiked)
-        << "\nisAgitated: " << (state & isAgitated)
-        << "\nisRemoved: " << (state & isRemoved)
-        << "\nneedsUpdate: " << (state & needsUpdate)
-        << "\nignoreCollision: " << (state & ignoreCollision)
+        << "\nisSpiked: " << (state() & isSpiked)
+        << "\nisAgitated: " << (state() & isAgitated)
+        << "\nisRemoved: " << (state() & isRemoved)
+        << "\nneedsUpdate: " << (state() & needsUpdate)
+        << "\nignoreCollision: " << (state() & ignoreCollision)
 
         << "\nmouseCache: " << mouseCache.toString()
         << "\nspeedMultiplier: " << speedMultiplier
 
-        << "\n\nshared: " << shared
-        << " {\n    use_count(): " << shared.use_count()
-        << "\n    get(): " << shared.get()
+        << "\n\nhandle: {"
+        << "\n    index(): " << handle.index()
+        << "\n    generation(): " << handle.generation()
+        << "\n    resolves? " << (map::resolve(handle) == this)
         << "\n}"
         << "\nobj: {"
-        << "\n    data: " << (obj.data.has_value() ? std::any_cast<e_ptr>(obj.data) : 0)
+        << "\n    entity: " << obj.entity
+        << "\n    flag: " << +obj.flag
         << "\n    bound: {"
         << "\n        x(): " << obj.bound.x()
         << "\n        y(): " << obj.bound.y()
@@ -278,14 +304,17 @@ std::string Entity::toString() noexcept {
 
         << "\n\nbirthTick: " << birthTick
         << "\ngame: " << game
-        << "\nis in quadtree? " << map::quadTree.contains(&obj)
-        << "\nis in its vector? " << 
-        (std::find(map::entities[type].begin(), map::entities[type].end(), shared) != map::entities[type].end());
+        << "\nis in quadtree? " << map::quadTree->contains(&obj)
+        << "\nis in its vector? " <<
+        (index < map::entities[type].size() && map::entities[type][index] == this);
         
     return ss.str();
 }
 
-Entity::Entity(const Vec2 &pos, float radius, const Color &color) noexcept {
+Entity::Entity(const Vec2 &pos, float radius, const Color &color, int _type) :
+    type(_type),
+    components(&map::components[_type]) {
+    row = components->add(this);
     setPosition(pos);
     setRadius(radius);
     setColor(color);
@@ -293,4 +322,5 @@ Entity::Entity(const Vec2 &pos, float radius, const Color &color) noexcept {
 }
 
 Entity::~Entity() {
+    components->remove(row);
 }
\ No newline at end of file
@@ -1,25 +1,39 @@
 #pragma once
 #include "../Game/Game.hpp"
 #include "../Modules/Utils.hpp"
-#include "../Modules/QuadTree.hpp"
+#include "../Modules/SpatialIndex.hpp"
+#include "../Modules/Slab.hpp"
+#include "Components.hpp"
 
+// Two entities map::resolveCollision() pushed apart, kept by the map
+// for as long as they are resolved every tick. normal points from B to A
+struct Contact {
+    Contact(Handle _A, Handle _B):
+        A(_A), B(_B) {
+    }
+    Handle A;
+    Handle B;
+    Vec2 normal{ 1, 0 };
+    double impulse = 0.0;        // Push per unit of inverse mass the last solve gave them
+    double penetration = 0.0;    // Overlap found by the last solve
+
+    // What the last solve started from, and where it left them
+    Vec2 offset;                 // A's position relative to B, rounded
+    float radiusA = 0.0f, radiusB = 0.0f;
+    Vec2 fromA, fromB;
+    Vec2 restA, restB;
+    unsigned long long tick = 0; // Last tick the pair was resolved
+};
 namespace {
-    struct Contact {
-        Contact(e_ptr _A, e_ptr _B):
-            A(_A), B(_B) {
-        }
-        e_ptr A = nullptr;
-        e_ptr B = nullptr;
-        Vec2 normal{ 1, 0 };
-        double impulse = 0.0f;
-        double penetration = 0.0f;
-    };
     unsigned int prevNodeId = 0;
 }
 class Game;
 class Player;
 
+// Position, size, movement and state live in the Components of the
+// entity's type; an Entity reads and writes them through its row
 class Entity {
+    friend struct Components;
 public:
     // Typing
     static const int TYPE            = -1;      // CellType the entity is classified as
@@ -28,15 +42,22 @@ public:
     unsigned char    canEat          = nothing; // Cell types this entity can eat
     unsigned char    avoidSpawningOn = nothing; // Cell types to be checked for safe spawn
 
-    // States
-    unsigned char state = 0x00;
+    // Timers an entity can schedule with map::schedule()
+    enum class Timer : unsigned char {
+        grow,       // Food growth
+        decay,      // PlayerCell radius decay
+        remerge,    // PlayerCell becomes able to merge
+        spawnGrace  // justSpawned runs out
+    };
 
     // Cached (for when owner disconnects)
     Vec2 mouseCache{ 0, 0 };
     unsigned int speedMultiplier = cfg::playerCell_speedMultiplier;
 
     // Miscc
-    e_ptr shared; // Shared pointer for this entity
+    Handle   handle;          // Handle for this entity, resolves until its slot is freed
+    unsigned index       = 0; // Position in map::entities[type]
+    unsigned movingIndex = 0; // Position in map::movingEntities while isMoving
     Collidable obj; // Object to insert into quadTree
 
     // Setters
@@ -54,8 +75,8 @@ public:
     // Getters
     Player *owner() const noexcept;
     const Color &color() const noexcept;
-    const Vec2 &position() const noexcept;
-    const Vec2 &velocity() const noexcept;
+    Vec2 position() const noexcept;
+    Vec2 velocity() const noexcept;
     float mass() const noexcept;
     float radius() const noexcept;
     float invMass() const noexcept;
@@ -66,32 +87,36 @@ public:
     unsigned int killerId() const noexcept;
     unsigned long long age() const noexcept;
 
+    // States (CellStateFlags)
+    unsigned char &state() noexcept;
+    unsigned char state() const noexcept;
+
     // Misc
     bool decelerate() noexcept;
-    bool intersects(e_ptr other) const noexcept;
+    bool intersects(const Entity *other) const noexcept;
     bool intersects(const Vec2 &pos, float radius) const noexcept;
     virtual void move() noexcept;
     virtual void pop() noexcept;
     virtual void split(double angle, float radius) noexcept;
     virtual void autoSplit() noexcept;
     virtual void update() noexcept;
+    virtual void onSpawned() noexcept;
     virtual void onDespawned() noexcept;
-    virtual void collideWith(e_ptr other) noexcept;
-    virtual void consume(e_ptr _prey) noexcept;
+    virtual void onTimer(Timer timer) noexcept;
+    virtual void onResized() noexcept;
+    virtual void collideWith(Entity *other) noexcept;
+    virtual void consume(Entity *_prey) noexcept;
     std::string toString() noexcept;
 
-    Entity(const Vec2&, float radius, const Color&) noexcept;
+    Entity(const Vec2&, float radius, const Color&, int _type);
+    Entity(const Entity&) = delete;
     virtual ~Entity();
 
 protected:
     Color _color{ 0, 0, 0 };
-    Vec2  _position{ 0, 0 };
-    Vec2  _velocity{ 1, 0 };
 
-    float _mass         = 0.0f;
-    float _radius       = 0.0f;
-    float _invMass      = 0.0f;
-    float _acceleration = 0.0f;
+    Components *components = nullptr; // Components of this entity's type
+    unsigned    row        = 0;       // This entity's row in components
 
     unsigned int      _nodeId    = 0;
     unsigned int      _killerId  = 0;
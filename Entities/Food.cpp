@@ -3,29 +3,40 @@
 #include "../Game/Game.hpp" // configs
 
 Food::Food(const Vec2 &pos, float radius, const Color &color) noexcept :
-    Entity(pos, radius, color) {
+    Entity(pos, radius, color, TYPE) {
 
     flag = food;
     canEat = cfg::food_canEat;
     avoidSpawningOn = cfg::food_avoidSpawningOn;
 
-    if (cfg::food_isSpiked)   state |= isSpiked;
-    if (cfg::food_isAgitated) state |= isAgitated;
+    if (cfg::food_isSpiked)   state() |= isSpiked;
+    if (cfg::food_isAgitated) state() |= isAgitated;
 }
-void Food::update() noexcept {
-    if (!cfg::food_canGrow || _radius >= cfg::food_maxRadius) 
+// Food gets a chance to grow every minute (1500 ticks)
+static const unsigned GROW_INTERVAL = 1500;
+
+void Food::onSpawned() noexcept {
+    // Start at a random point of the minute, so all food does not grow at once.
+    // Scheduled even if it cannot grow now, as food.canGrow and food.maxRadius
+    // may be changed while it lives
+    map::schedule(this, Timer::grow, (unsigned)rand(1, (int)GROW_INTERVAL));
+}
+void Food::onTimer(Timer timer) noexcept {
+    if (timer != Timer::grow) {
+        Entity::onTimer(timer);
+        return;
+    }
+    map::schedule(this, Timer::grow, GROW_INTERVAL);
+    if (!cfg::food_canGrow || radius() >= cfg::food_maxRadius)
         return;
 
     // 10% chance to grow every minute
-    if (++growTick > 1500) {
-        if (rand(0, 10) == 10)
-            setMass(_mass + 1); // setMass might be faster in this case
-        growTick = 0;
-    }
+    if (rand(0, 10) == 10)
+        setMass(mass() + 1); // setMass might be faster in this case
 }
 void Food::onDespawned() noexcept {
     // Vanilla servers spawn new food as soon as one is eaten, so lets do that
-    if (map::entities[Food::TYPE].size() < cfg::food_startAmount)
+    if (map::count(Food::TYPE) < cfg::food_startAmount)
         map::spawn<Food>(randomPosition(), cfg::food_baseRadius, randomColor());
 }
 Food::~Food() {
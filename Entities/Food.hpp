@@ -6,9 +6,8 @@ public:
     static const int TYPE = 0;
 
     Food(const Vec2&, float radius, const Color&) noexcept;
-    void update() noexcept;
+    void onSpawned() noexcept;
     void onDespawned() noexcept;
+    void onTimer(Timer timer) noexcept;
     ~Food();
-private:
-    unsigned short growTick = 0;
 };
\ No newline at end of file
@@ -3,18 +3,18 @@
 #include "../Game/Game.hpp" // configs
 
 MotherCell::MotherCell(const Vec2 &pos, float radius, const Color &color) noexcept :
-    Entity(pos, radius, color) {
+    Entity(pos, radius, color, TYPE) {
 
     flag = mothercells;
     canEat = cfg::motherCell_canEat;
     avoidSpawningOn = cfg::motherCell_avoidSpawningOn;
 
-    if (cfg::motherCell_isSpiked)   state |= isSpiked;
-    if (cfg::motherCell_isAgitated) state |= isAgitated;
+    if (cfg::motherCell_isSpiked)   state() |= isSpiked;
+    if (cfg::motherCell_isAgitated) state() |= isAgitated;
 }
 void MotherCell::onDespawned() noexcept {
     // Spawn a new one immediately
-    if (map::entities[MotherCell::TYPE].size() < cfg::motherCell_startAmount)
+    if (map::count(MotherCell::TYPE) < cfg::motherCell_startAmount)
         map::spawn<MotherCell>(randomPosition(), cfg::motherCell_baseRadius, cfg::motherCell_color);
 }
 MotherCell::~MotherCell() {
@@ -5,52 +5,90 @@
 #include "../Game/Map.hpp"
 #include "../Game/Game.hpp" // configs
 #include "../Player/Player.hpp"
+#include "../Modules/MoveKernel.hpp"
 
 PlayerCell::PlayerCell(const Vec2 &pos, float radius, const Color &color) noexcept :
-    Entity(pos, radius, color) {
+    Entity(pos, radius, color, TYPE) {
 
     flag = playercells;
     canEat = cfg::playerCell_canEat;
     avoidSpawningOn = cfg::playerCell_avoidSpawningOn;
 
-    if (cfg::playerCell_isSpiked)   state |= isSpiked;
-    if (cfg::playerCell_isAgitated) state |= isAgitated;
+    if (cfg::playerCell_isSpiked)   state() |= isSpiked;
+    if (cfg::playerCell_isAgitated) state() |= isAgitated;
 }
-void PlayerCell::move() noexcept {
-    if (speedMultiplier == 0) return;
+// r^-0.4396754 for radii up to SPEED_TABLE_SIZE - 1, one entry per unit of radius.
+// Interpolating between entries keeps the relative error below 3.1e-4 for radii
+// of SPEED_TABLE_MIN and up; radii outside the table fall back to std::pow
+static constexpr unsigned SPEED_TABLE_MIN  = 16;
+static constexpr unsigned SPEED_TABLE_SIZE = 2048;
 
-    if (_owner->state() != PlayerState::DISCONNECTED)
-        mouseCache = _owner->mouse();
+static float speedFactor(float radius) noexcept {
+    static const std::vector<float> table = [] {
+        std::vector<float> powers(SPEED_TABLE_SIZE + 1);
+        for (unsigned r = 1; r <= SPEED_TABLE_SIZE; ++r)
+            powers[r] = (float)std::pow((double)r, -0.4396754);
+        return powers;
+    }();
+    if (!(radius >= SPEED_TABLE_MIN && radius < SPEED_TABLE_SIZE))
+        return (float)std::pow(radius, -0.4396754);
+    unsigned r = (unsigned)radius;
+    return table[r] + (table[r + 1] - table[r]) * (radius - r);
+}
+
+// Moves every playercell toward its owner's mouse in one pass over the
+// playercell components. Targets and speeds are gathered first, so the
+// movement and border clamp run over contiguous arrays
+void PlayerCell::moveAll() noexcept {
+    static std::vector<double> targetX, targetY;
+    static std::vector<float> step;
+    static std::vector<unsigned char> moved;
 
-    // Difference between centers
-    Vec2 dir = (mouseCache - _position).round();
-    double distance = (int)dir.squared();
+    Components &cells = map::components[TYPE];
+    const unsigned count = cells.size();
+    targetX.resize(count);
+    targetY.resize(count);
+    step.resize(count);
+    moved.resize(count);
 
-    // Not enough of a difference to move
-    if (distance <= 1) return;
+    for (unsigned row = 0; row < count; ++row) {
+        PlayerCell *cell = static_cast<PlayerCell*>(cells.entity[row]);
+        if (cells.flags[row] & isRemoved || cell->speedMultiplier == 0) {
+            // A zero step never moves
+            targetX[row] = cells.x[row];
+            targetY[row] = cells.y[row];
+            step[row] = 0;
+            continue;
+        }
+        if (cell->_owner->state() != PlayerState::DISCONNECTED)
+            cell->mouseCache = cell->_owner->mouse();
+        targetX[row] = cell->mouseCache.x;
+        targetY[row] = cell->mouseCache.y;
 
-    // distance between mouse and cell
-    distance = std::sqrt(distance);
+        // https://imgur.com/a/H9s0J
+        // s = min(d, 2.2 * (r^-0.4396754) * t * m) / d
+        step[row] = 2.2f * speedFactor(cells.radius[row]) * cfg::game_timeStep * cell->speedMultiplier;
+    }
 
-    // https://imgur.com/a/H9s0J
-    // s = min(d, 2.2 * (r^-0.4396754) * t * m) / d
-    double speed = 2.2 * std::pow(_radius, -0.4396754); // speed per millisecond
-    speed *= cfg::game_timeStep * speedMultiplier; // speed per tick
+    const Rect &bounds = map::bounds();
+    movekernel::move(cells.x.data(), cells.y.data(), cells.vx.data(), cells.vy.data(), cells.radius.data(),
+        targetX.data(), targetY.data(), step.data(), moved.data(), count,
+        { bounds.left(), bounds.bottom(), bounds.right(), bounds.top() });
 
-    // limit the speed and check > 0 to prevent jittering
-    speed = std::min(distance, speed) / distance;
-    if (speed > 0)
-        // Move to target at normalized speed then validate position
-        setPosition(_position + dir * speed, true);
+    // Positions are already written, so this only syncs bounds and the index
+    for (unsigned row = 0; row < count; ++row) {
+        if (moved[row])
+            cells.entity[row]->setPosition(cells.entity[row]->position());
+    }
 }
 void PlayerCell::autoSplit() noexcept {
-    if (_mass <= cfg::playerCell_maxMass || _owner->cells.size() > cfg::player_maxCells 
+    if (mass() <= cfg::playerCell_maxMass || _owner->cells.size() > cfg::player_maxCells 
         || _owner->isForceMerging)
         return;
 
     unsigned int remaining  = cfg::player_maxCells - (int)_owner->cells.size();
-    unsigned int splitTimes = std::min((unsigned int)std::ceil(_mass / cfg::playerCell_maxMass), remaining);
-    float splitRadius = toRadius(std::min(_mass / splitTimes, cfg::playerCell_maxMass));
+    unsigned int splitTimes = std::min((unsigned int)std::ceil(mass() / cfg::playerCell_maxMass), remaining);
+    float splitRadius = toRadius(std::min(mass() / splitTimes, cfg::playerCell_maxMass));
 
     if (_owner->cells.size() == cfg::player_maxCells - 1) {
         ++splitTimes;
@@ -65,33 +103,33 @@ void PlayerCell::pop() noexcept {
     int cellsLeft = cfg::player_maxCells - (int)_owner->cells.size();
     if (cellsLeft <= 0) return;
 
-    float splitMass = _mass / cellsLeft;
+    float splitMass = mass() / cellsLeft;
     std::vector<float> masses;
     masses.reserve(cellsLeft);
 
     if (splitMass <= cfg::playerCell_minMassToSplit) {
         unsigned int amount = 2;
-        for (; _mass > cfg::playerCell_minMassToSplit * amount
+        for (; mass() > cfg::playerCell_minMassToSplit * amount
             && amount < cfg::player_maxCells; amount *= 2);
         cellsLeft = std::min(cellsLeft, (int)amount);
-        splitMass = _mass / cellsLeft;
+        splitMass = mass() / cellsLeft;
         cellsLeft -= 1;
         setMass(splitMass);
     } else {
-        float nextMass = _mass * 0.5f;
+        float nextMass = mass() * 0.5f;
         float totalMass = nextMass;
         while (_owner->cells.size() + masses.size() < cfg::player_maxCells) {
             splitMass = nextMass / cfg::player_maxCells;
             if (splitMass < cfg::playerCell_minMassToSplit) {
                 float totalProjectedMass = totalMass + splitMass * cellsLeft;
                 float prevMass = nextMass;
-                nextMass = _mass - totalProjectedMass;
-                while (totalMass + (prevMass / 2) * cellsLeft > _mass && cellsLeft > 0) {
+                nextMass = mass() - totalProjectedMass;
+                while (totalMass + (prevMass / 2) * cellsLeft > mass() && cellsLeft > 0) {
                     nextMass = prevMass / 2;
                     if (nextMass < cfg::playerCell_minMassToSplit)
                         break;
-                    if (totalMass + nextMass + splitMass * (cellsLeft-1) > _mass)
-                        nextMass -= totalMass + nextMass + splitMass * (cellsLeft-1) - _mass;
+                    if (totalMass + nextMass + splitMass * (cellsLeft-1) > mass())
+                        nextMass -= totalMass + nextMass + splitMass * (cellsLeft-1) - mass();
                     totalMass += nextMass;
                     masses.push_back(nextMass);
                     --cellsLeft;
@@ -102,14 +140,14 @@ void PlayerCell::pop() noexcept {
                     //Logger::warn(splitMass);
                     break;
                 }
-                if (totalMass + (prevMass / 2) * cellsLeft == _mass && cellsLeft > 0) {
+                if (totalMass + (prevMass / 2) * cellsLeft == mass() && cellsLeft > 0) {
                     prevMass /= cellsLeft;
                     if (prevMass < cfg::playerCell_minMassToSplit)
                         break;
                     for (; cellsLeft > 0; --cellsLeft)
                         masses.push_back(prevMass);
                 }
-                while (totalProjectedMass < _mass && cellsLeft > 0) {
+                while (totalProjectedMass < mass() && cellsLeft > 0) {
                     if (nextMass < cfg::playerCell_minMassToSplit)
                         nextMass *= 2;
                     if (nextMass < cfg::playerCell_minMassToSplit)
@@ -121,7 +159,7 @@ void PlayerCell::pop() noexcept {
                 }
                 break;
             }
-            if (cellsLeft == 1 && totalMass + (nextMass / 2) < _mass)
+            if (cellsLeft == 1 && totalMass + (nextMass / 2) < mass())
                 nextMass = nextMass;
             else
                 nextMass /= 2;
@@ -129,7 +167,7 @@ void PlayerCell::pop() noexcept {
             masses.push_back(nextMass);
             --cellsLeft;
         }
-        setRadius(_radius * INV_SQRT_2);
+        setRadius(radius() * INV_SQRT_2);
     }
     for (; splitMass < cfg::playerCell_minVirusSplitMass; splitMass *= 2);
     for (; cellsLeft > 0; --cellsLeft)
@@ -140,28 +178,29 @@ void PlayerCell::pop() noexcept {
 }
 void PlayerCell::split(double angle, float radius) noexcept {
     // Spawn cell at splitting cell's position with new radius
-    sptr<PlayerCell> newCell = map::spawn<PlayerCell>(_position + 20, radius, _color, false);
+    PlayerCell *newCell = map::spawn<PlayerCell>(position() + 20, radius, _color, false);
     newCell->setVelocity(cfg::playerCell_initialAcceleration, angle);
     newCell->setOwner(_owner);
     newCell->setCreator(_creatorId);
     newCell->speedMultiplier = _owner->state() == PlayerState::DISCONNECTED ? 0 : speedMultiplier;
 
     // Add new cell to owner's cells
+    newCell->ownerIndex = (unsigned)_owner->cells.size();
     _owner->cells.push_back(newCell);
 
     if (_owner->socket != nullptr)
         _owner->packetHandler.sendPacket(_owner->protocol->addNode(newCell->nodeId()));
 }
-void PlayerCell::consume(e_ptr prey) noexcept {
+void PlayerCell::consume(Entity *prey) noexcept {
     // Ejected cells ignore eat collision from the cell they were ejected
     // from for about 2 seconds (50 ticks) after initial boost
-    if (prey->type == Ejected::TYPE && prey->creator() == _nodeId && prey->age() <= 50)
+    if (prey->type == Ejected::TYPE && prey->creator() == _nodeId && prey->state() & justSpawned)
         return;
     // Do not gain mass from bots
     if (!(prey->type == PlayerCell::TYPE && 
         prey->mass() <= cfg::playerCell_minMassToSplit * 0.5f && 
-        _mass >= cfg::playerCell_maxMass / cfg::playerCell_minMassToSplit))
-        setMass(_mass + prey->mass());
+        mass() >= cfg::playerCell_maxMass / cfg::playerCell_minMassToSplit))
+        setMass(mass() + prey->mass());
     // Split on a virus or mothercell
     if (prey->type == Virus::TYPE || prey->type == MotherCell::TYPE)
         pop();
@@ -169,31 +208,64 @@ void PlayerCell::consume(e_ptr prey) noexcept {
     map::despawn(prey); // remove prey from map
 }
 void PlayerCell::update() noexcept {
-    move();
- 
     // Update remerge
-    float base = std::max(cfg::player_baseRemergeTime, std::floor(_radius * 0.2f)) * 25;
-    if ((_owner && _owner->isForceMerging) || cfg::player_baseRemergeTime <= 0)
-        state = _acceleration < 150 ? (state | ignoreCollision) : (state & ~ignoreCollision);
-    else
-        state = age() >= base ? (state | ignoreCollision) : (state & ~ignoreCollision);
-
-    // Update decay once per second
-    if (++decayTick > 25) {
-        decayTick = 0;
-        if (cfg::playerCell_radiusDecayRate <= 0) 
+    bool merging = (_owner && _owner->isForceMerging) || cfg::player_baseRemergeTime <= 0
+        ? acceleration() < 150 : canRemerge;
+    state() = merging ? (state() | ignoreCollision) : (state() & ~ignoreCollision);
+}
+unsigned PlayerCell::remergeTime() const noexcept {
+    return (unsigned)(std::max(cfg::player_baseRemergeTime, std::floor(radius() * 0.2f)) * 25);
+}
+void PlayerCell::checkRemerge() noexcept {
+    unsigned long long due = remergeTime();
+    canRemerge = age() >= due;
+    // Timers cannot be cancelled, so one already scheduled for an other age
+    // is left to fire and ignored
+    if (!canRemerge && due != remergeCheck) {
+        remergeCheck = due;
+        map::schedule(this, Timer::remerge, (unsigned)(due - age()));
+    }
+}
+void PlayerCell::onSpawned() noexcept {
+    checkRemerge();
+    // Start at a random point of the second, so all cells do not decay at once
+    map::schedule(this, Timer::decay, (unsigned)rand(1, 25));
+}
+void PlayerCell::onResized() noexcept {
+    // Growing pushes its remerge time back, shrinking brings it forward
+    checkRemerge();
+}
+void PlayerCell::onTimer(Timer timer) noexcept {
+    switch (timer) {
+    case Timer::remerge:
+        if (age() == remergeCheck)
+            checkRemerge();
+        break;
+    case Timer::decay: {
+        // Update decay once per second
+        map::schedule(this, Timer::decay, 25);
+        if (cfg::playerCell_radiusDecayRate <= 0)
             return;
         float newRadius = std::sqrt(radiusSquared() * cfg::playerCell_radiusDecayRate);
         if (newRadius <= cfg::playerCell_baseRadius)
             return;
         setRadius(newRadius);
+        break;
+    }
+    default:
+        Entity::onTimer(timer);
     }
 }
 void PlayerCell::onDespawned() noexcept {
     if (!_owner) return;
 
-    // Remove from owner's cells
-    _owner->cells.erase(std::find(_owner->cells.begin(), _owner->cells.end(), shared));
+    // Remove from owner's cells, keeping the others in the order they
+    // spawned in, which Player::onSplit() goes by. There are at most
+    // player.maxCells of them, so shifting the rest down is cheap
+    std::vector<Entity*> &cells = _owner->cells;
+    cells.erase(cells.begin() + ownerIndex);
+    for (unsigned i = ownerIndex; i < cells.size(); ++i)
+        static_cast<PlayerCell*>(cells[i])->ownerIndex = i;
 
     if (_owner->cells.empty()) {
         if (_owner->state() != PlayerState::DISCONNECTED) {
@@ -6,14 +6,22 @@ public:
     static const int TYPE = 4;
 
     PlayerCell(const Vec2&, float radius, const Color&) noexcept;
-    void move() noexcept;
+    static void moveAll() noexcept;
     void autoSplit() noexcept;
     void pop() noexcept;
     void split(double angle, float radius) noexcept;
     void update() noexcept;
-    void consume(e_ptr _prey) noexcept;
+    void consume(Entity *_prey) noexcept;
+    void onSpawned() noexcept;
     void onDespawned() noexcept;
+    void onTimer(Timer timer) noexcept;
+    void onResized() noexcept;
+    void checkRemerge() noexcept; // Updates canRemerge, scheduling the next check if too young
     ~PlayerCell();
+    unsigned ownerIndex = 0; // Position in owner's cells
 private:
-    unsigned char decayTick = 0;
+    bool canRemerge = false; // Old enough to merge with the owner's other cells
+    unsigned long long remergeCheck = 0; // Age the remerge timer that counts fires at
+
+    unsigned remergeTime() const noexcept; // Age in ticks at which it can merge
 };
\ No newline at end of file
@@ -8,6 +8,6 @@ public:
     Virus(const Vec2&, float radius, const Color&) noexcept;
     void split(double angle, float radius) noexcept;
     void onDespawned() noexcept;
-    void consume(e_ptr prey) noexcept;
+    void consume(Entity *prey) noexcept;
     ~Virus();
 };
\ No newline at end of file
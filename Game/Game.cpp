@@ -91,6 +91,9 @@ void Game::mainLoop() {
     for (i = 0; i < server.playerBots.size(); ++i)
         server.playerBots[i]->update();
 
+    // Every player has seen this tick's changes, so they can be forgotten
+    map::endTick();
+
     // Update leaderboard once per second
     if (server.clients.size() && tickCount % 25 == 0)
         updateLeaderboard();
@@ -148,6 +151,11 @@ void Game::loadConfig() {
     cfg::game_mapHeight = config["game"]["mapHeight"];
     cfg::game_quadTreeLeafCapacity = config["game"]["quadTreeLeafCapacity"];
     cfg::game_quadTreeMaxDepth = config["game"]["quadTreeMaxDepth"];
+    cfg::game_spatialIndex = config["game"]["spatialIndex"].get<std::string>();
+    cfg::game_quadTreeLooseness = config["game"]["quadTreeLooseness"];
+    cfg::game_gridCellSize = config["game"]["gridCellSize"];
+    cfg::game_spatialIndexUpdate = config["game"]["spatialIndexUpdate"].get<std::string>();
+    cfg::game_collisionThreads = config["game"]["collisionThreads"];
 
     cfg::entity_decelerationPerTick = config["entity"]["decelerationPerTick"];
     cfg::entity_minAcceleration = config["entity"]["minAcceleration"];
@@ -165,6 +173,8 @@ void Game::loadConfig() {
     cfg::player_chanceToSpawnFromEjected = config["player"]["chanceToSpawnFromEjected"];
     cfg::player_collisionIgnoreTime = config["player"]["collisionIgnoreTime"];
 
+    cfg::playerBot_foodTargets = config["playerBot"]["foodTargets"];
+
     cfg::playerCell_baseRadius = config["playerCell"]["baseRadius"];
     cfg::playerCell_maxMass = config["playerCell"]["maxMass"];
     cfg::playerCell_minMassToSplit = config["playerCell"]["minMassToSplit"];
@@ -275,6 +285,11 @@ double game_mapWidth;
 double game_mapHeight;
 unsigned int game_quadTreeLeafCapacity;
 unsigned int game_quadTreeMaxDepth;
+std::string game_spatialIndex;
+double game_quadTreeLooseness;
+double game_gridCellSize;
+std::string game_spatialIndexUpdate;
+unsigned int game_collisionThreads;
 
 float entity_decelerationPerTick;
 float entity_minAcceleration;
@@ -292,6 +307,8 @@ float player_baseRemergeTime;
 int player_chanceToSpawnFromEjected;
 unsigned long long player_collisionIgnoreTime;
 
+unsigned int playerBot_foodTargets;
+
 float playerCell_baseRadius;
 float playerCell_maxMass;
 float playerCell_minMassToSplit;
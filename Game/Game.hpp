@@ -57,6 +57,11 @@ extern double game_mapWidth;
 extern double game_mapHeight;
 extern unsigned int game_quadTreeLeafCapacity;
 extern unsigned int game_quadTreeMaxDepth;
+extern std::string game_spatialIndex;
+extern double game_quadTreeLooseness;
+extern double game_gridCellSize;
+extern std::string game_spatialIndexUpdate;
+extern unsigned int game_collisionThreads;
 
 extern float entity_decelerationPerTick;
 extern float entity_minAcceleration;
@@ -75,6 +80,8 @@ extern float player_baseRemergeTime;
 extern int player_chanceToSpawnFromEjected;
 extern unsigned long long player_collisionIgnoreTime;
 
+extern unsigned int playerBot_foodTargets;
+
 extern float playerCell_baseRadius;
 extern float playerCell_maxMass;
 extern float playerCell_minMassToSplit;
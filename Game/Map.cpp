@@ -2,50 +2,161 @@
 #include "../Game/Game.hpp"
 #include "../Player/Player.hpp"
 #include "../Modules/Logger.hpp"
+#include "../Modules/QuadTree.hpp"
+#include "../Modules/ArenaQuadTree.hpp"
+#include "../Modules/SpatialGrid.hpp"
+#include "../Modules/TimerWheel.hpp"
+#include "../Modules/SweepAndPrune.hpp"
+#include "../Modules/WorkerPool.hpp"
 #include "../Entities/Food.hpp"
 #include "../Entities/Virus.hpp"
 #include "../Entities/Ejected.hpp"
 #include "../Entities/MotherCell.hpp"
 #include "../Entities/PlayerCell.hpp"
+#include <chrono> // map::updateIndex(), map::reconcileIndex()
+#include <thread> // std::thread::hardware_concurrency()
+#include <unordered_map>
 
 namespace map {
 
-std::vector<e_ptr> movingEntities{};
-std::vector<std::vector<e_ptr>> entities{
-    std::vector<sptr<Food::Entity>>(),
-    std::vector<sptr<Virus::Entity>>(),
-    std::vector<sptr<Ejected::Entity>>(),
-    std::vector<sptr<MotherCell::Entity>>(),
-    std::vector<sptr<PlayerCell::Entity>>()
+std::vector<Handle> movingEntities{};
+unsigned movingPeak = 0;
+std::vector<std::vector<Entity*>> entities{
+    std::vector<Entity*>(), // Food
+    std::vector<Entity*>(), // Virus
+    std::vector<Entity*>(), // Ejected
+    std::vector<Entity*>(), // MotherCell
+    std::vector<Entity*>()  // PlayerCell
 };
+std::vector<Components> components(PlayerCell::TYPE + 1);
+
+// Storage for each entity type, indexed by TYPE like entities
+template <typename T>
+static Slab<T, Entity> slab{ T::TYPE };
+static SlabBase<Entity> *const slabs[] = {
+    &slab<Food>, &slab<Virus>, &slab<Ejected>, &slab<MotherCell>, &slab<PlayerCell>
+};
+static_assert(Food::TYPE == 0 && Virus::TYPE == 1 && Ejected::TYPE == 2 && MotherCell::TYPE == 3 &&
+    PlayerCell::TYPE == 4, "slabs must be in TYPE order");
+
+static std::vector<Handle> updated;   // Entities marked needsUpdate this tick
+static std::vector<Handle> dirty;     // Entities marked needsReindex since the last reindex()
+static std::vector<Handle> despawned; // Graveyard: entities removed from entities and freed at the end of this tick
+static unsigned dead[PlayerCell::TYPE + 1]; // Despawned entities of each type still in entities
+
+// A scheduled call to onTimer(). Handles are checked against the node id
+// as well, as a freed slot may be reused many times before a timer fires
+struct EntityTimer {
+    Handle        handle;
+    unsigned int  nodeId;
+    Entity::Timer timer;
+};
+static TimerWheel<EntityTimer> timers; // Advanced once at the start of every update()
 
 Game *game;
-QuadTree quadTree;
+std::unique_ptr<PartitionedIndex> quadTree;
+bool rebuildIndex = false;
+IndexUpdateCost indexUpdateCost;
+CollisionCounters collisionCounters;
+
+// Both index update modes are timed once every this many ticks
+static constexpr unsigned long long indexSampleInterval = 250;
+static bool sampling = false;
+static std::chrono::steady_clock::duration incrementalTime;
+
+// Reused by update() so the broad phase does not allocate every tick.
+// Collision may move or despawn entities, so pairs are gathered up
+// front rather than found while they are being resolved
+static SweepAndPrune broadPhase;
+static std::vector<Entity*> broadPhaseEntities; // Entity of each broad phase box
+
+// Sweeps the broad phase in parallel when collisionThreads is not 1. Pairs
+// are still resolved one at a time in the same order, so results match
+// the single-threaded sweep, which is rerun to check them while sampling
+static std::unique_ptr<WorkerPool> collisionWorkers;
+static std::vector<SweepAndPrune::Pair> parallelPairs;
+
+// Contacts resolved this tick or the last, by the node ids of the pair
+// (lower first). Those of pairs that stopped touching are dropped once a
+// second, and ignored until then
+static std::unordered_map<unsigned long long, Contact> contacts;
+static constexpr unsigned long long contactPruneInterval = 25;
+
+static unsigned long long contactKey(const Entity *A, const Entity *B) noexcept {
+    unsigned long long a = A->nodeId(), b = B->nodeId();
+    return a < b ? a << 32 | b : b << 32 | a;
+}
+
+// Drops the contacts of pairs that no longer touch (or no longer exist)
+static void pruneContacts() noexcept {
+    for (auto it = contacts.begin(); it != contacts.end();) {
+        if (it->second.tick != game->tickCount) it = contacts.erase(it);
+        else ++it;
+    }
+}
+
+// Types an entity can collide with: its own (rigid collisions),
+// the ones it can eat and the ones that can eat it
+static unsigned char collisionTypes(const Entity *entity) noexcept {
+    unsigned char types = entity->flag | entity->canEat;
+    if (cfg::food_canEat & entity->flag)       types |= food;
+    if (cfg::virus_canEat & entity->flag)      types |= viruses;
+    if (cfg::ejected_canEat & entity->flag)    types |= ejected;
+    if (cfg::motherCell_canEat & entity->flag) types |= mothercells;
+    if (cfg::playerCell_canEat & entity->flag) types |= playercells;
+    return types;
+}
 
 void init(Game *_game) {
-    Logger::info("Creating QuadTree...");
+    Logger::info("Creating spatial index (", cfg::game_spatialIndex, ")...");
 
     game = _game;
-    quadTree = QuadTree({
-        0,
-        0,
-        cfg::game_mapWidth,
-        cfg::game_mapHeight
-    }, cfg::game_quadTreeLeafCapacity, cfg::game_quadTreeMaxDepth);
+    timers.reset(game->tickCount + 1);
+    contacts.clear();
+    Rect mapBounds(0, 0, cfg::game_mapWidth, cfg::game_mapHeight);
+    auto makeIndex = [&]() -> std::unique_ptr<SpatialIndex> {
+        if (cfg::game_spatialIndex == "arenaQuadTree") {
+            return std::make_unique<ArenaQuadTree>(mapBounds,
+                cfg::game_quadTreeLeafCapacity, cfg::game_quadTreeMaxDepth, cfg::game_quadTreeLooseness);
+        }
+        if (cfg::game_spatialIndex == "grid")
+            return std::make_unique<SpatialGrid>(mapBounds, cfg::game_gridCellSize);
+        return std::make_unique<QuadTree>(mapBounds,
+            cfg::game_quadTreeLeafCapacity, cfg::game_quadTreeMaxDepth, cfg::game_quadTreeLooseness);
+    };
+    if (cfg::game_spatialIndex != "quadTree" && cfg::game_spatialIndex != "arenaQuadTree" && cfg::game_spatialIndex != "grid")
+        Logger::warn("Unknown spatial index '", cfg::game_spatialIndex, "', using quadTree.");
+    // Food, viruses and mothercells only move once in a while (when shot or spawned moving)
+    quadTree = std::make_unique<PartitionedIndex>(makeIndex(), makeIndex(), food | viruses | mothercells);
+    rebuildIndex = cfg::game_spatialIndexUpdate == "rebuild";
+    if (!rebuildIndex && cfg::game_spatialIndexUpdate != "incremental")
+        Logger::warn("Unknown spatial index update mode '", cfg::game_spatialIndexUpdate, "', using incremental.");
+
+    unsigned threads = cfg::game_collisionThreads;
+    if (threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u);
+    collisionWorkers.reset(threads > 1 ? new WorkerPool(threads) : nullptr);
+    Logger::info("Finding collisions on ", threads, threads > 1 ? " threads." : " thread.");
+
+    // Food is respawned as it is eaten, before the eaten food's slot is
+    // freed at the end of the tick, so leave some room past the start amount
+    slab<Food>.reserve(cfg::food_startAmount + cfg::food_startAmount / 8);
+    slab<Virus>.reserve(cfg::virus_maxAmount);
+    components[Food::TYPE].reserve(cfg::food_startAmount + cfg::food_startAmount / 8);
+    components[Virus::TYPE].reserve(cfg::virus_maxAmount);
 
     // Spawn starting food
     Logger::info("Spawning ", cfg::food_startAmount, " food...");
-    while (entities[Food::TYPE].size() < cfg::food_startAmount)
+    while (count(Food::TYPE) < cfg::food_startAmount)
         spawn<Food>(randomPosition(), cfg::food_baseRadius, randomColor());
 
     // Spawn starting viruses
     Logger::info("Spawning ", cfg::virus_startAmount, " viruses...");
-    while (entities[Virus::TYPE].size() < cfg::virus_startAmount)
+    while (count(Virus::TYPE) < cfg::virus_startAmount)
         spawn<Virus>(randomPosition(), cfg::virus_baseRadius, cfg::virus_color);
 
     /*// Spawn starting mothercells
     Logger::info("Spawning ", cfg::motherCell_startAmount, " mothercells...");
-    while (entities[MotherCell::TYPE].size() < cfg::motherCell_startAmount)
+    while (count(MotherCell::TYPE) < cfg::motherCell_startAmount)
         spawn<MotherCell>(randomPosition(), cfg::motherCell_baseRadius, cfg::motherCell_color);*/
 
     // Spawn starting player bots
@@ -54,124 +165,340 @@ void init(Game *_game) {
 }
 
 const Rect &bounds() noexcept {
-    return quadTree.getBounds();
+    return quadTree->getBounds();
 }
  
 template <typename T>
-sptr<T> spawn(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept {
-    sptr<T> entity = std::make_shared<T>(pos, radius, color); // Initial
-    entity->type   = T::TYPE;
-    entity->shared = entity; // 1
+T *spawn(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept {
+    Handle handle;
+    T *entity      = slab<T>.create(handle, pos, radius, color); // Initial
+    entity->handle = handle;
+    entity->state() &= ~needsUpdate; // Clients are sent all of it when it comes into view
     const float r  = radius * 2; // Width/height of circular shape
 
     // Check if entity should use safespawn
     if (checkSafe && entity->avoidSpawningOn != nothing) {
-        // Get entities near this one
-        std::vector<Collidable*> found = quadTree.getObjectsInBound({ pos.x, pos.y, r, r });
-
+        // Checks entities near pos, stopping at the first one to avoid.
+        // May run in the middle of another query (e.g. from onDespawned
+        // during collision), so the results are not buffered anywhere
+        auto isSafe = [&]() {
+            return quadTree->forEachInBound({ pos.x, pos.y, r, r }, [&](Collidable *obj) {
+                Entity *cell = obj->entity;
+                if (cell == nullptr) return true;
+                return !((entity->avoidSpawningOn & cell->flag) && cell->intersects(pos, r));
+            });
+        };
         // Get safe position
-        int attempts = (int)entities[T::TYPE].size();
-        for (;!found.empty() && attempts > 0 && std::any_of(found.begin(), found.end(), [&](Collidable *obj) {
-            if (!obj->data.has_value()) return false;
-            e_ptr cell = std::any_cast<e_ptr>(obj->data);
-            return (entity->avoidSpawningOn & cell->flag) && cell->intersects(pos, r);
-        }); --attempts) {
-            // Retry
-            pos = randomPosition();
-            found = quadTree.getObjectsInBound({ pos.x, pos.y, r, r });
-        }
+        for (int attempts = (int)count(T::TYPE); attempts > 0 && !isSafe(); --attempts)
+            pos = randomPosition(); // Retry
     }
     entity->setPosition(pos); // Set cells position to safe one (if necessary)
-    entity->obj = Collidable({ pos.x, pos.y, r, r }, entity->shared); // 2
+    entity->obj = Collidable({ pos.x, pos.y, r, r }, entity, entity->flag);
     entity->setBirthTick(game);
-    quadTree.insert(&entity->obj); // insert into quadTree
-    entities[T::TYPE].push_back(entity->shared); // (3) insert into vector of its type
+    quadTree->insert(&entity->obj); // insert into quadTree
+    entity->index = (unsigned)entities[T::TYPE].size();
+    entities[T::TYPE].push_back(entity); // insert into vector of its type
+    entity->onSpawned();
     return entity;
 }
-template sptr<Food> spawn<Food>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
-template sptr<Virus> spawn<Virus>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
-template sptr<Ejected> spawn<Ejected>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
-template sptr<PlayerCell> spawn<PlayerCell>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
-template sptr<MotherCell> spawn<MotherCell>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
+template Food *spawn<Food>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
+template Virus *spawn<Virus>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
+template Ejected *spawn<Ejected>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
+template PlayerCell *spawn<PlayerCell>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
+template MotherCell *spawn<MotherCell>(Vec2 pos, float radius, const Color &color, bool checkSafe) noexcept;
 
-void despawn(e_ptr entity) noexcept {
-    if (!entity || entity->state & isRemoved) {
+void despawn(Entity *entity) noexcept {
+    if (!entity || entity->state() & isRemoved) {
         Logger::error("Entity is already removed.");
         return;
     }
     // Remove from quadTree
-    if (!quadTree.remove(&entity->obj)) {
+    if (!quadTree->remove(&entity->obj)) {
         Logger::error("Entity could not be removed from quadTree.");
         Logger::debug(entity->toString());
         //return;
     }
-    // Erase from vector of its type
-    std::vector<e_ptr> &vec = entities[entity->type];
-    std::vector<e_ptr>::iterator index = std::find(vec.begin(), vec.end(), entity->shared);
-    if (index == vec.end()) {
-        Logger::error("Entity was not in its vector.");
+    entity->state() |= isRemoved; // Mark as removed
+    ++dead[entity->type];
+    entity->onDespawned();      // Special onDespawned event
+    entity->obj.entity = nullptr;
+    despawned.push_back(entity->handle);
+}
+
+unsigned count(int type) noexcept {
+    return (unsigned)entities[type].size() - dead[type];
+}
+
+Entity *resolve(Handle handle) noexcept {
+    return slabs[handle.type()]->get(handle);
+}
+
+void schedule(Entity *entity, Entity::Timer timer, unsigned delay) noexcept {
+    timers.schedule(delay, { entity->handle, entity->nodeId(), timer });
+}
+
+size_t pendingTimers() noexcept {
+    return timers.size();
+}
+
+size_t cachedContacts() noexcept {
+    return contacts.size();
+}
+
+unsigned collisionThreads() noexcept {
+    return collisionWorkers ? collisionWorkers->size() : 1;
+}
+
+void startMoving(Entity *entity) noexcept {
+    if (entity->state() & isMoving) return;
+    entity->state() |= isMoving;
+    entity->movingIndex = (unsigned)movingEntities.size();
+    movingEntities.push_back(entity->handle);
+}
+
+// Drops the entry at index from movingEntities, moving the last one into its place
+static void stopMoving(unsigned index) noexcept {
+    if (Entity *entity = resolve(movingEntities[index]))
+        entity->state() &= ~isMoving;
+    movingEntities[index] = movingEntities.back();
+    movingEntities.pop_back();
+    if (index < movingEntities.size()) {
+        if (Entity *moved = resolve(movingEntities[index]))
+            moved->movingIndex = index;
+    }
+}
+
+const SlabBase<Entity> &pool(int type) noexcept {
+    return *slabs[type];
+}
+
+void markUpdated(Entity *entity) noexcept {
+    if (entity->handle) // Not yet spawned -- spawn() clears the mark itself
+        updated.push_back(entity->handle);
+}
+
+void markDirty(Entity *entity) noexcept {
+    if (entity->state() & needsReindex || !entity->handle)
+        return; // Already marked, or not yet spawned -- spawn() inserts it itself
+    entity->state() |= needsReindex;
+    dirty.push_back(entity->handle);
+}
+
+void touch(Entity *entity) noexcept {
+    if (entity->handle && !(entity->state() & (isRemoved | needsReindex)))
+        quadTree->touch(&entity->obj); // Reindexing stamps it anyway
+}
+
+void endTick() noexcept {
+    for (Handle handle : updated) {
+        if (Entity *entity = resolve(handle))
+            entity->state() &= ~needsUpdate;
+    }
+    updated.clear();
+    for (Handle handle : despawned) {
+        Entity *entity = resolve(handle);
+        if (!entity) continue;
+        // Swap-remove from the vector of its type
+        std::vector<Entity*> &vec = entities[entity->type];
+        vec[entity->index] = vec.back();
+        vec[entity->index]->index = entity->index;
+        vec.pop_back();
+        slabs[handle.type()]->destroy(handle);
+    }
+    despawned.clear();
+    std::fill(std::begin(dead), std::end(dead), 0);
+}
+
+// Moves an object within the spatial index as it moves on the map. In
+// rebuild mode, moving objects are left for the rebuild to place
+static bool updateIndex(Collidable *obj) noexcept {
+    if (rebuildIndex && !quadTree->isStatic(obj))
+        return true;
+    if (!sampling)
+        return quadTree->update(obj);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool updated = quadTree->update(obj);
+    incrementalTime += std::chrono::steady_clock::now() - start;
+    return updated;
+}
+
+// Updates the spatial index once for every entity marked dirty since the
+// last tick, however many times each was moved or resized in between
+static void reindex() noexcept {
+    for (Handle handle : dirty) {
+        Entity *entity = resolve(handle);
+        if (!entity) continue; // Freed
+        entity->state() &= ~needsReindex;
+        if (entity->state() & isRemoved || updateIndex(&entity->obj))
+            continue;
+        Logger::error("Entity could not be updated: ", entity->toString());
+        // If removed from quadtree and not re-inserted for ANY reason, re-insert it.
+        if (!quadTree->contains(&entity->obj))
+            quadTree->insert(&entity->obj);
+    }
+    dirty.clear();
+}
+
+static long long microseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+// Brings the spatial index up to date once per tick, after collisions
+// and before players look at it: dirty entities are reindexed, then in
+// rebuild mode the dynamic index is rebuilt. While sampling, the mode
+// that is not in use is timed as well
+static void reconcileIndex() {
+    reindex();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!rebuildIndex) {
+        if (!sampling) return;
+        indexUpdateCost.incremental = microseconds(incrementalTime);
+        quadTree->rebuild(); // Already up to date, but costs the same
+        indexUpdateCost.rebuild = microseconds(std::chrono::steady_clock::now() - start);
         return;
     }
-    vec.erase(index);
-    entity->state |= isRemoved; // Mark as removed
-    entity->onDespawned();      // Special onDespawned event
-    entity->obj.data.reset();   // Remove reference of shared pointer in quadTree
-    entity->shared.reset();     // Remove last reference of shared pointer
+    if (sampling) {
+        // Updating every mover once is what incremental mode would have done
+        for (Entity *entity : entities[PlayerCell::TYPE])
+            quadTree->update(&entity->obj);
+        for (Handle handle : movingEntities) {
+            if (Entity *entity = resolve(handle)) quadTree->update(&entity->obj);
+        }
+        indexUpdateCost.incremental = microseconds(std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+    }
+    quadTree->rebuild();
+    if (sampling)
+        indexUpdateCost.rebuild = microseconds(std::chrono::steady_clock::now() - start);
 }
 
 // Update entities
 void update() {
-    // Update food
-    for (unsigned i = 0; i < entities[Food::TYPE].size(); ++i) {
-        sptr<Food::Entity> food = entities[Food::TYPE][i];
-        if (food && !(food->state & isRemoved))
-            food->update();
-    }
-    // Update playercells
-    for (unsigned i = 0; i < entities[PlayerCell::TYPE].size(); ++i) {
-        sptr<PlayerCell::Entity> playerCell = entities[PlayerCell::TYPE][i];
-        if (!playerCell || playerCell->state & isRemoved)
+    sampling = game->tickCount % indexSampleInterval == 0;
+    incrementalTime = {};
+    quadTree->setEpoch(game->tickCount);
+
+    // Fire this tick's timers. Entities with nothing due cost nothing
+    timers.advance([](const EntityTimer &due) {
+        Entity *entity = resolve(due.handle);
+        if (entity && entity->nodeId() == due.nodeId && !(entity->state() & isRemoved))
+            entity->onTimer(due.timer);
+    });
+    // Move playercells, then update them, walking their component rows in
+    // order. Rows are only freed at the end of the tick, so they hold still
+    // while we walk them. Cells split off here are appended and updated
+    // this tick too, but only move from the next
+    PlayerCell::moveAll();
+    Components &playerCells = components[PlayerCell::TYPE];
+    for (unsigned row = 0; row < playerCells.size(); ++row) {
+        if (playerCells.flags[row] & isRemoved)
             continue;
+        Entity *playerCell = playerCells.entity[row];
         playerCell->update();
         playerCell->autoSplit();
-        if (playerCell->acceleration())
-            continue;
-        for (Collidable *obj : quadTree.getObjectsInBound(playerCell->obj.bound)) {
-            if (!playerCell || playerCell->state & isRemoved) break;
-            if (!obj->data.has_value()) continue;
-            playerCell->collideWith(std::any_cast<e_ptr>(obj->data));
-        }
     }
-    // Update moving entities
+    // Move moving entities, keeping them in the dynamic index while they move.
+    // Walking backwards, stopMoving() only moves in entries already visited
     for (int i = (int)movingEntities.size() - 1; i >= 0; --i) {
-        e_ptr entity = movingEntities[i];
-        if (!entity || entity->state & isRemoved || !entity->decelerate()) {
-            movingEntities.erase(movingEntities.begin() + i);
+        Entity *entity = resolve(movingEntities[i]);
+        if (!entity || entity->state() & isRemoved) {
+            stopMoving(i);
             continue;
         }
-        for (Collidable *obj : quadTree.getObjectsInBound(entity->obj.bound)) {
-            if (!entity || entity->state & isRemoved) break;
-            if (!obj->data.has_value()) continue;
-            entity->collideWith(std::any_cast<e_ptr>(obj->data));
+        quadTree->setMoving(&entity->obj);
+        if (!entity->decelerate()) {
+            quadTree->setResting(&entity->obj);
+            stopMoving(i);
         }
     }
+    // Broad phase: every entity goes in. Playercells at rest and moving
+    // entities (not those set moving by these collisions) are the active
+    // ones, ranked in the order their collisions are resolved
+    broadPhase.clear();
+    broadPhaseEntities.clear();
+    for (int type = Food::TYPE; type <= PlayerCell::TYPE; ++type) {
+        Components &cells = components[type];
+        for (unsigned row = 0; row < cells.size(); ++row) {
+            if (cells.flags[row] & isRemoved)
+                continue;
+            Entity *entity = cells.entity[row];
+            unsigned order = SweepAndPrune::PASSIVE;
+            if (cells.flags[row] & isMoving)
+                order = playerCells.size() + entity->movingIndex;
+            else if (type == PlayerCell::TYPE && !cells.acceleration[row])
+                order = row;
+            const float x = (float)cells.x[row], y = (float)cells.y[row], r = cells.radius[row];
+            broadPhase.add(x - r, y - r, x + r, y + r, entity->flag, collisionTypes(entity), order);
+            broadPhaseEntities.push_back(entity);
+        }
+    }
+    const std::vector<SweepAndPrune::Pair> &pairs = broadPhase.sweep(collisionWorkers.get());
+    if (sampling && collisionWorkers) {
+        parallelPairs.assign(pairs.begin(), pairs.end());
+        broadPhase.sweep();
+        if (!std::equal(pairs.begin(), pairs.end(), parallelPairs.begin(), parallelPairs.end(),
+            [](const SweepAndPrune::Pair &a, const SweepAndPrune::Pair &b) {
+                return a.first == b.first && a.second == b.second && a.mutual == b.mutual;
+            })) {
+            Logger::error("Parallel collision pairs differ from single-threaded ones, "
+                "finding collisions on 1 thread from now on.");
+            collisionWorkers.reset();
+        }
+    }
+    collisionCounters.queries += broadPhase.activeCount();
+    collisionCounters.candidates += pairs.size();
+
+    // Narrow phase, once per overlapping pair. collideWith() only lets the
+    // bigger of two playercells of different owners eat, so when both are
+    // active each gets its turn, as when each looked for its own collisions
+    for (const SweepAndPrune::Pair &pair : pairs) {
+        Entity *entity = broadPhaseEntities[pair.first];
+        Entity *other = broadPhaseEntities[pair.second];
+        if (entity->state() & isRemoved || other->state() & isRemoved)
+            continue;
+        if (entity->intersects(other)) ++collisionCounters.hits;
+        entity->collideWith(other);
+        if (pair.mutual)
+            other->collideWith(entity); // Returns if either was eaten
+    }
+    if (game->tickCount % contactPruneInterval == 0)
+        pruneContacts();
+    movingPeak = std::max(movingPeak, (unsigned)movingEntities.size());
+
+    // Players see where collisions left everything. Collisions are found
+    // from the components rather than the index, so this is the one pass
+    // over what changed this tick (and between ticks, from commands)
+    reconcileIndex();
 }
 
-void resolveCollision(e_ptr A, e_ptr B) noexcept {
-    // Check distance between cells
-    Vec2 mtd = (A->position() - B->position()).round();
-    float r = A->radius() + B->radius();
-    double dist = mtd.length();
+void resolveCollision(Entity *A, Entity *B) noexcept {
+    auto cached = contacts.try_emplace(contactKey(A, B), A->handle, B->handle);
+    Contact &contact = cached.first->second;
+    // A contact carries over while its pair is resolved every tick. One
+    // left from before, or from entities that had these node ids, starts over
+    bool persisted = !cached.second && contact.tick + 1 >= game->tickCount &&
+        ((contact.A == A->handle && contact.B == B->handle) ||
+         (contact.A == B->handle && contact.B == A->handle));
+    if (!persisted)
+        contact = Contact(A->handle, B->handle);
+    contact.tick = game->tickCount;
+    // Solve the pair the way around its contact was made. Pushing them
+    // apart is symmetric, so this ends up in exactly the same place
+    if (contact.A != A->handle)
+        std::swap(A, B);
+    ++collisionCounters.contacts;
 
-    // Special case (cells are exactly on top of eachother)
-    if (dist == 0.0) {
-        dist = r - 1.0;
-        mtd = Vec2(r, 0.0);
+    // A player's own cells that come to the solve exactly as they did last
+    // tick are resting against each other. Solving would leave them where
+    // it did then, so they are put back there until one of them moves
+    bool sameSize = persisted && contact.radiusA == A->radius() && contact.radiusB == B->radius();
+    if (sameSize && A->owner() && A->owner() == B->owner() &&
+        A->position() == contact.fromA && B->position() == contact.fromB) {
+        ++collisionCounters.resting;
+        A->setPosition(contact.restA, true);
+        B->setPosition(contact.restB, true);
+        return;
     }
-    // Get minimum translation distance
-    double penetration = r - dist;
-    Vec2 normal = mtd / dist;
-    mtd = normal * penetration;
 
     // Get impulses
     float impulseSum = A->invMass() + B->invMass();
@@ -179,30 +506,63 @@ void resolveCollision(e_ptr A, e_ptr B) noexcept {
     // Cell has infinite mass, do not move
     if (impulseSum == 0) return;
 
-    // Momentum
-    mtd /= impulseSum;
+    // Check distance between cells
+    contact.fromA = A->position();
+    contact.fromB = B->position();
+    Vec2 offset = (A->position() - B->position()).round();
+
+    // Overlapping as they did last tick (cells grinding against each
+    // other), the pair is warm started: pushed along the same normal by
+    // the same impulse, which solving would come to again
+    if (sameSize && offset == contact.offset) {
+        ++collisionCounters.warm;
+    } else {
+        float r = A->radius() + B->radius();
+        Vec2 mtd = offset;
+        double dist = mtd.length();
+
+        // Special case (cells are exactly on top of eachother): push them
+        // apart the way the pair was last pushed, if it was
+        if (dist == 0.0) {
+            dist = r - 1.0;
+            mtd = persisted ? Vec2(contact.normal).normalize() * r : Vec2(r, 0.0);
+        }
+        // Get minimum translation distance
+        contact.offset = offset;
+        contact.radiusA = A->radius();
+        contact.radiusB = B->radius();
+        contact.penetration = r - dist;
+        contact.normal = mtd / dist;
+        // Momentum
+        contact.impulse = contact.penetration / impulseSum;
+    }
 
-    // push-pull them apart based off their mass    
-    A->setPosition(A->position() + mtd * A->invMass(), true);
-    B->setPosition(B->position() - mtd * B->invMass(), true);
+    // push-pull them apart based off their mass
+    Vec2 push = contact.normal * contact.impulse;
+    A->setPosition(A->position() + push * A->invMass(), true);
+    B->setPosition(B->position() - push * B->invMass(), true);
 
     // (experimental) resolving penetration
     float percent = 0.0015f; // Percentage to move (higher= more jitter, less overlap)
     float slop = 0.001f; // If penetration is less than slop value then don't correct
 
     // Positional correction vector
-    Vec2 correction = normal * percent * (std::max(penetration - slop, 0.0) / impulseSum);
+    Vec2 correction = contact.normal * percent * (std::max(contact.penetration - slop, 0.0) / impulseSum);
 
     // Move away from each other based on correction amount
     A->setPosition(A->position() + correction * A->invMass(), true);
     B->setPosition(B->position() - correction * B->invMass(), true);
+    contact.restA = A->position();
+    contact.restB = B->position();
 }
 
 void cleanup() {
     Logger::warn("Clearing Map...");
 
     game->commands.despawn({ "all" });
-    quadTree.clear();
+    endTick();
+    movingEntities.clear();
+    quadTree->clear();
 }
 
 } // namespace map
\ No newline at end of file
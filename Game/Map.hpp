@@ -1,5 +1,6 @@
 #pragma once
 #include "../Entities/Entity.hpp"
+#include "../Modules/PartitionedIndex.hpp"
 
 class Game;
 
@@ -11,18 +12,98 @@ void cleanup();
 const Rect &bounds() noexcept;
 
 template <typename T>
-sptr<T> spawn(Vec2 pos, float radius, const Color &color, bool checkSafe = true) noexcept;
+T *spawn(Vec2 pos, float radius, const Color &color, bool checkSafe = true) noexcept;
 
-void despawn(e_ptr entity) noexcept;
+// Takes an entity off the map in O(1). It stays in entities and readable
+// (marked isRemoved) until endTick(), so clients can be told who ate it
+void despawn(Entity *entity) noexcept;
+
+// Entities of a type that have not been despawned
+unsigned count(int type) noexcept;
+
+// Entity a handle refers to, or nullptr once it has been despawned and its slot freed
+Entity *resolve(Handle handle) noexcept;
+
+// Records that an entity has needsUpdate set, so endTick() can clear it
+void markUpdated(Entity *entity) noexcept;
+
+// Calls entity->onTimer(timer) delay ticks from now, unless the entity
+// has been despawned by then
+void schedule(Entity *entity, Entity::Timer timer, unsigned delay) noexcept;
+
+// Timers scheduled and not yet fired, including those of despawned entities
+size_t pendingTimers() noexcept;
+
+// Threads finding collision pairs, 1 if they are found on the game thread
+unsigned collisionThreads() noexcept;
+
+// Adds an entity to movingEntities unless it is already there
+void startMoving(Entity *entity) noexcept;
+
+// Storage entities of a type are drawn from
+const SlabBase<Entity> &pool(int type) noexcept;
+
+// Clears this tick's needsUpdate marks, swap-removes despawned entities
+// from entities and frees their slots. Runs once every player has seen
+// what changed this tick
+void endTick() noexcept;
 
 void update();
 
-void resolveCollision(e_ptr cell1, e_ptr cell2) noexcept;
+// Pushes two overlapping entities apart. The pair's Contact is cached
+// while they touch, so a pair that overlaps as it did last tick is warm
+// started from its last normal and impulse, and a player's own cells left
+// resting against each other are skipped until one of them moves
+void resolveCollision(Entity *cell1, Entity *cell2) noexcept;
+
+// Contacts cached, including those of pairs not yet pruned since they stopped touching
+size_t cachedContacts() noexcept;
+
+// Records that an entity's position or size changed. The spatial index
+// catches up with every marked entity at once, at the end of each tick
+void markDirty(Entity *entity) noexcept;
+
+// Records that an entity changed in a way clients see but that leaves its
+// bounds alone, so that it is found by queries for what changed
+void touch(Entity *entity) noexcept;
+
+// Time taken to keep the spatial index up to date for a tick in each of
+// the two modes, in microseconds, as last sampled (-1 until sampled)
+struct IndexUpdateCost {
+    long long incremental = -1;
+    long long rebuild     = -1;
+};
+extern IndexUpdateCost indexUpdateCost;
+
+// Running totals of collision detection since the map was created. Every
+// active entity (a playercell at rest or a moving entity) in a broad phase
+// sweep counts as a query. Candidates are the pairs of overlapping bounds
+// the sweep finds, of which hits are those whose circles actually touch.
+// Contacts are the pairs given to resolveCollision(). Warm ones were pushed
+// as they were last tick, overlapping the same way, and resting ones (a
+// player's own cells that had not moved since) were skipped
+struct CollisionCounters {
+    unsigned long long queries    = 0;
+    unsigned long long candidates = 0;
+    unsigned long long hits       = 0;
+    unsigned long long contacts   = 0;
+    unsigned long long warm       = 0;
+    unsigned long long resting    = 0;
+};
+extern CollisionCounters collisionCounters;
+
+// Whether the spatial index is rebuilt once per tick (game.spatialIndexUpdate
+// "rebuild") rather than updated every time an entity moves
+extern bool rebuildIndex;
 
-extern std::vector<e_ptr> movingEntities;
-extern std::vector<std::vector<e_ptr>> entities;
+// Entities with isMoving set, each at its movingIndex. Despawned ones
+// are dropped when the next tick decelerates them
+extern std::vector<Handle> movingEntities;
+extern unsigned movingPeak; // Most moving entities at the end of a tick since the last debug report
+extern std::vector<std::vector<Entity*>> entities; // Entities of each type, owned by their slabs, despawned ones included
+extern std::vector<Components> components;         // Hot data of each type's entities, despawned ones included
 
-extern QuadTree quadTree;
+extern std::unique_ptr<PartitionedIndex> quadTree;
 extern Game *game;
 extern float dt;
 
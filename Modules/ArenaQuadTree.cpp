@@ -0,0 +1,584 @@
+#include "ArenaQuadTree.hpp"
+#include "BoxScan.hpp"
+#include <algorithm> // ArenaQuadTree::ArenaQuadTree(), ArenaQuadTree::visitNode(), ArenaQuadTree::rebuild(), ArenaQuadTree::collectNodeStats()
+#include <queue>     // ArenaQuadTree::getNearestObjects()
+#include <cmath>     // ArenaQuadTree::rebuild()
+
+ArenaQuadTree::ArenaQuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel, double _looseness) :
+    capacity(_capacity),
+    maxLevel(_maxLevel),
+    collapseThreshold(_capacity / 2),
+    looseness(std::max(_looseness, 1.0)) {
+    nodes.emplace_back();
+    nodes[ROOT].bounds = _bound;
+    nodes[ROOT].loose.update(_bound.x(), _bound.y(), _bound.width() * looseness, _bound.height() * looseness);
+    nodes[ROOT].objects.reserve(_capacity);
+}
+
+// Inserts an object into the deepest node that can contain it
+bool ArenaQuadTree::insert(Collidable *obj) {
+    if (obj->node != NONE) return false;
+    attach(locate(ROOT, obj->bound), obj);
+    return true;
+}
+
+// Removes an object from this quadtree
+bool ArenaQuadTree::remove(Collidable *obj) noexcept {
+    if (!contains(obj))
+        return false; // Cannot exist in vector
+
+    unsigned index = obj->node;
+    detach(obj);
+    collapse(index);
+    return true;
+}
+
+// Moves object to the node its current bound belongs in (for objects that move)
+bool ArenaQuadTree::update(Collidable *obj) {
+    if (!contains(obj)) return false;
+
+    // Climb to the nearest node that still contains the object and descend from there
+    unsigned index = obj->node;
+    unsigned start = index;
+    while (nodes[start].parent != NONE && !nodes[start].loose.contains(obj->bound))
+        start = nodes[start].parent;
+    unsigned target = locate(start, obj->bound);
+
+    // Still belongs where it is -- only its copy of the bound needs refreshing
+    if (target == index) {
+        nodes[index].setBound(obj->slot, obj->bound);
+        stamp(index);
+        return true;
+    }
+    detach(obj);
+    attach(target, obj);
+
+    // Old node may have dropped below the collapse threshold
+    collapse(index);
+    return true;
+}
+
+// Check if object exists in quadtree
+bool ArenaQuadTree::contains(Collidable *obj) const noexcept {
+    if (obj->node >= nodes.size()) return false;
+    const std::vector<Collidable*> &objects = nodes[obj->node].objects;
+    return obj->slot < objects.size() && objects[obj->slot] == obj;
+}
+
+bool ArenaQuadTree::touch(Collidable *obj) noexcept {
+    if (!contains(obj)) return false;
+    stamp(obj->node);
+    return true;
+}
+
+// Walks quadtree for objects within the provided boundary. Recurses
+// rather than keeping a shared stack so that queries may nest
+bool ArenaQuadTree::visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    return visitNode(ROOT, bound, types, since, visit, context);
+}
+bool ArenaQuadTree::visitNode(unsigned index, const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    const Node &node = nodes[index];
+    if (node.changed < since) return true; // Nothing changed below here
+    if (!mayContain(node.occupancy, types)) return true; // Nothing of the requested types below here
+
+    const unsigned count = (unsigned)node.objects.size();
+    counters.examined += count;
+    const float qLeft = (float)bound.left(), qBottom = (float)bound.bottom();
+    const float qRight = (float)bound.right(), qTop = (float)bound.top();
+
+    // Test up to 64 boxes per scan, then visit the hits
+    for (unsigned base = 0; base < count; base += 64) {
+        uint64_t hits = boxscan::scan(&node.left[base], &node.bottom[base], &node.right[base], &node.top[base],
+            std::min(count - base, 64u), qLeft, qBottom, qRight, qTop);
+        for (; hits != 0; hits &= hits - 1) {
+            Collidable *obj = node.objects[base + boxscan::lowestBit(hits)];
+            // Only check for intersection with OTHER boundaries
+            if (&obj->bound == &bound || !matches(obj->flag, types))
+                continue;
+            ++counters.returned;
+            if (!visit(obj, context))
+                return false;
+        }
+    }
+    if (node.isLeaf()) return true;
+
+    // Descend into the one child that fully contains bound, otherwise every intersecting
+    // child. Loose children overlap, so those always need checking individually
+    if (looseness == 1) {
+        unsigned child = getChild(index, bound);
+        if (child != NONE)
+            return visitNode(child, bound, types, since, visit, context);
+    }
+    for (unsigned i = 0; i < 4; ++i) {
+        if (nodes[node.firstChild + i].loose.intersects(bound) &&
+            !visitNode(node.firstChild + i, bound, types, since, visit, context))
+            return false;
+    }
+    return true;
+}
+
+// Best-first search for the nearest objects. A node's loose bounds hold
+// everything below it, so its distance is a lower bound for its objects
+void ArenaQuadTree::getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+    unsigned char types, double maxDistance) const {
+    double limit = maxDistance * maxDistance;
+    std::priority_queue<NearestEntry<unsigned>> queue;
+    queue.push({ 0, nullptr, ROOT }); // Objects outside the map are kept in the root
+    while (k > 0 && !queue.empty()) {
+        NearestEntry<unsigned> entry = queue.top();
+        queue.pop();
+        if (entry.distance > limit) break;
+        if (entry.obj != nullptr) {
+            out.push_back(entry.obj);
+            --k;
+            continue;
+        }
+        const Node &node = nodes[entry.region];
+        if (!mayContain(node.occupancy, types)) continue;
+        for (Collidable *obj : node.objects) {
+            if (matches(obj->flag, types))
+                queue.push({ obj->bound.distanceSquared(x, y), obj, NONE });
+        }
+        if (node.isLeaf()) continue;
+        for (unsigned i = 0; i < 4; ++i)
+            queue.push({ nodes[node.firstChild + i].loose.distanceSquared(x, y), nullptr, node.firstChild + i });
+    }
+}
+
+// Returns total children count for this quadtree
+unsigned ArenaQuadTree::totalChildren() const noexcept {
+    return (unsigned)(nodes.size() - 1 - freeBlocks.size() * 4);
+}
+
+// Returns total object count for this quadtree
+unsigned ArenaQuadTree::totalObjects() const noexcept {
+    return subtreeObjects(ROOT);
+}
+
+const Rect &ArenaQuadTree::getBounds() const noexcept {
+    return nodes[ROOT].bounds;
+}
+
+// Removes all objects and children from this quadtree
+void ArenaQuadTree::clear() noexcept {
+    for (Node &node : nodes) {
+        for (Collidable *obj : node.objects)
+            obj->node = NONE;
+        node.resize(0);
+        node.occupancy.clear();
+    }
+    nodes.resize(1);
+    nodes[ROOT].changed = epoch;
+    nodes[ROOT].firstChild = NONE;
+    freeBlocks.clear();
+}
+
+// Quadrant index (as stored in firstChild..firstChild+3) <-> Morton digit (y bit, x bit).
+// The mapping swaps 0 and 1 only, so it is its own inverse
+static constexpr unsigned MORTON_DIGIT[4] = { 1, 0, 2, 3 };
+
+// Spreads the 32 bits of v out to the even bits of the result
+static uint64_t spreadBits(uint64_t v) noexcept {
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2))  & 0x3333333333333333ull;
+    v = (v | (v << 1))  & 0x5555555555555555ull;
+    return v;
+}
+static unsigned leadingZeros(uint64_t v) noexcept {
+    if (v == 0) return 64;
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return 63 - (unsigned)index;
+    #else
+        return (unsigned)__builtin_clzll(v);
+    #endif
+}
+
+// Builds a fresh, compact tree from the current bounds of every object. Each
+// object is given the Morton code of the deepest node it fits in, the codes are
+// sorted so that each subtree becomes one contiguous run, and the tree is then
+// built top-down in a single pass over the runs
+void ArenaQuadTree::rebuild() {
+    const Rect &root = nodes[ROOT].bounds;
+    const unsigned deepest = std::min(maxLevel, MAX_BUILD_LEVEL);
+    const double steps = 4294967296.0; // Positions are quantized to 2^32 steps per axis
+    auto quantize = [steps](double v, double origin, double size) {
+        return (uint64_t)std::clamp((v - origin) / size * steps, 0.0, steps - 1);
+    };
+
+    buildEntries.clear();
+    for (Node &node : nodes) {
+        for (Collidable *obj : node.objects) {
+            const Rect &bound = obj->bound;
+            if (!root.contains(bound)) {
+                buildEntries.push_back({ 0, obj }); // Sticks out of the map -- kept in the root
+                continue;
+            }
+            uint64_t code = 0;
+            unsigned level = 0;
+            if (looseness == 1) {
+                // Deepest node holding both corners, i.e. their common Morton prefix
+                uint64_t low = spreadBits(quantize(bound.left(), root.left(), root.width())) |
+                    spreadBits(quantize(bound.bottom(), root.bottom(), root.height())) << 1;
+                uint64_t high = spreadBits(quantize(bound.right(), root.left(), root.width())) |
+                    spreadBits(quantize(bound.top(), root.bottom(), root.height())) << 1;
+                level = std::min(leadingZeros(low ^ high) / 2, deepest);
+                code = low;
+            } else {
+                // Deepest node holding the center whose loose bounds still hold bound.
+                // Every level where bound is within the loose margin fits, wherever the center is
+                uint64_t x = quantize(bound.x(), root.left(), root.width());
+                uint64_t y = quantize(bound.y(), root.bottom(), root.height());
+                double margin = (looseness - 1) * 0.5;
+                double fit = std::min(margin * root.width() / std::max(bound.halfWidth(), 1e-9),
+                                      margin * root.height() / std::max(bound.halfHeight(), 1e-9));
+                level = fit < 2 ? 0 : (unsigned)std::min(std::log2(fit), (double)deepest);
+                while (level < deepest) {
+                    double w = root.width() / (double)(1ull << (level + 1));
+                    double h = root.height() / (double)(1ull << (level + 1));
+                    double left = root.left() + (double)(x >> (31 - level)) * w;
+                    double bottom = root.bottom() + (double)(y >> (31 - level)) * h;
+                    if (bound.left() < left - margin * w || bound.right() > left + w + margin * w ||
+                        bound.bottom() < bottom - margin * h || bound.top() > bottom + h + margin * h)
+                        break;
+                    ++level;
+                }
+                code = spreadBits(x) | spreadBits(y) << 1;
+            }
+            // Keep only the digits of the levels above the node it belongs in
+            code &= level == 0 ? 0 : ~0ull << (64 - 2 * level);
+            buildEntries.push_back({ code | level, obj });
+        }
+        node.resize(0);
+        node.occupancy.clear();
+        node.firstChild = NONE;
+        node.changed = epoch;
+    }
+    // Every block is unused now. Hand them out lowest index first to keep the tree compact
+    freeBlocks.clear();
+    for (unsigned first = (unsigned)nodes.size(); first > 1; first -= 4)
+        freeBlocks.push_back(first - 4);
+
+    sortEntries();
+    build(ROOT, 0, (unsigned)buildEntries.size());
+}
+
+// Radix sorts buildEntries by key, a byte per pass
+void ArenaQuadTree::sortEntries() {
+    const unsigned size = (unsigned)buildEntries.size();
+    if (size == 0) return;
+    sortBuffer.resize(size);
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        unsigned offsets[256] = {};
+        for (const BuildEntry &entry : buildEntries)
+            ++offsets[(entry.key >> shift) & 0xFF];
+        if (offsets[(buildEntries[0].key >> shift) & 0xFF] == size)
+            continue; // Every key has the same byte here
+
+        for (unsigned i = 0, total = 0; i < 256; ++i) {
+            unsigned count = offsets[i];
+            offsets[i] = total;
+            total += count;
+        }
+        for (const BuildEntry &entry : buildEntries)
+            sortBuffer[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        buildEntries.swap(sortBuffer);
+    }
+}
+
+// Builds the subtree at index from buildEntries[begin, end), which all belong in it
+void ArenaQuadTree::build(unsigned index, unsigned begin, unsigned end) {
+    unsigned level = nodes[index].level;
+
+    // Keep everything here, as a leaf that never reached capacity would
+    if (end - begin < capacity || level >= maxLevel || level >= MAX_BUILD_LEVEL) {
+        for (; begin < end; ++begin)
+            place(index, buildEntries[begin].obj);
+        return;
+    }
+    // Objects belonging in this node sort before anything in its children
+    for (; begin < end && (buildEntries[begin].key & 63) == level; ++begin)
+        place(index, buildEntries[begin].obj);
+
+    unsigned first = allocateBlock();
+    for (unsigned i = 0; i < 4; ++i) {
+        Node &child = nodes[first + i];
+        childBounds(nodes[index].bounds, i, child.bounds, child.loose);
+        child.parent = index;
+        child.level = level + 1;
+        child.firstChild = NONE;
+        child.changed = epoch;
+    }
+    nodes[index].firstChild = first;
+
+    // Each child's objects are the run sharing the next Morton digit
+    unsigned shift = 62 - 2 * level;
+    while (begin < end) {
+        uint64_t digit = (buildEntries[begin].key >> shift) & 3;
+        unsigned run = begin + 1;
+        while (run < end && ((buildEntries[run].key >> shift) & 3) == digit)
+            ++run;
+        build(first + MORTON_DIGIT[digit], begin, run);
+        begin = run;
+    }
+    for (unsigned i = 0; i < 4; ++i)
+        nodes[index].occupancy.add(nodes[first + i].occupancy);
+}
+
+// Appends object to a node as is, for build() (which keeps occupancy itself)
+void ArenaQuadTree::place(unsigned index, Collidable *obj) {
+    Node &node = nodes[index];
+    obj->node = index;
+    obj->slot = (unsigned)node.objects.size();
+    node.push(obj);
+    node.occupancy.add(obj->flag);
+}
+
+// Returns the deepest node below index that fully contains bound
+unsigned ArenaQuadTree::locate(unsigned index, const Rect &bound) const noexcept {
+    while (!nodes[index].isLeaf()) {
+        unsigned child = getChild(index, bound);
+        if (child == NONE) break; // Straddles this node's center
+        index = child;
+    }
+    return index;
+}
+
+// Appends object to a node, subdividing if required
+void ArenaQuadTree::attach(unsigned index, Collidable *obj) {
+    Node &node = nodes[index];
+    obj->node = index;
+    obj->slot = (unsigned)node.objects.size();
+    node.push(obj);
+    for (unsigned i = index; i != NONE; i = nodes[i].parent)
+        nodes[i].occupancy.add(obj->flag);
+    stamp(index);
+
+    if (node.isLeaf() && node.level < maxLevel && node.objects.size() >= capacity)
+        subdivide(index);
+}
+
+// Swaps object with the last one in its node and pops it
+void ArenaQuadTree::detach(Collidable *obj) noexcept {
+    Node &node = nodes[obj->node];
+    unsigned last = (unsigned)node.objects.size() - 1;
+    node.copy(last, obj->slot);
+    node.objects[obj->slot]->slot = obj->slot;
+    node.resize(last);
+    for (unsigned i = obj->node; i != NONE; i = nodes[i].parent)
+        nodes[i].occupancy.remove(obj->flag);
+    stamp(obj->node);
+    obj->node = NONE;
+}
+
+// Subdivides into four quadrants and pushes down every object that fits in one
+void ArenaQuadTree::subdivide(unsigned index) {
+    unsigned first = allocateBlock(); // May grow nodes -- take references afterwards
+    Node &node = nodes[index];
+
+    for (unsigned i = 0; i < 4; ++i) {
+        Node &child = nodes[first + i];
+        childBounds(node.bounds, i, child.bounds, child.loose);
+        child.parent = index;
+        child.level = node.level + 1;
+        child.firstChild = NONE;
+        child.changed = epoch;
+    }
+    node.firstChild = first;
+    ++counters.subdivisions;
+
+    // Keep straddlers here, move everything else down a level
+    unsigned kept = 0;
+    for (unsigned i = 0; i < node.objects.size(); ++i) {
+        Collidable *obj = node.objects[i];
+        unsigned child = getChild(index, obj->bound);
+        if (child == NONE) {
+            obj->slot = kept;
+            node.copy(i, kept++);
+            continue;
+        }
+        obj->node = child;
+        obj->slot = (unsigned)nodes[child].objects.size();
+        nodes[child].push(obj);
+        nodes[child].occupancy.add(obj->flag);
+    }
+    node.resize(kept);
+
+    for (unsigned i = 0; i < 4; ++i) {
+        const Node &child = nodes[first + i];
+        if (child.level < maxLevel && child.objects.size() >= capacity)
+            subdivide(first + i);
+    }
+}
+
+// Stamps a node and its ancestors with the current epoch. Ancestors are
+// never stamped earlier than their descendants, so the walk can stop at
+// the first node that already has it
+void ArenaQuadTree::stamp(unsigned index) noexcept {
+    for (unsigned i = index; i != NONE && nodes[i].changed != epoch; i = nodes[i].parent)
+        nodes[i].changed = epoch;
+}
+
+// Merges children back into their parent once the subtree has emptied
+// enough. Merging below a threshold rather than the moment a node drops
+// under capacity keeps objects near the boundary from thrashing the tree
+void ArenaQuadTree::collapse(unsigned index) noexcept {
+    unsigned current = nodes[index].isLeaf() ? nodes[index].parent : index;
+
+    while (current != NONE) {
+        Node &node = nodes[current];
+        for (unsigned i = 0; i < 4; ++i) {
+            if (!nodes[node.firstChild + i].isLeaf())
+                return;
+        }
+        if (subtreeObjects(current) > collapseThreshold)
+            return;
+
+        for (unsigned i = 0; i < 4; ++i) {
+            Node &child = nodes[node.firstChild + i];
+            for (Collidable *obj : child.objects) {
+                obj->node = current;
+                obj->slot = (unsigned)node.objects.size();
+                node.push(obj);
+            }
+            child.resize(0); // Keeps its capacity for when the block is reused
+            child.occupancy.clear();
+        }
+        freeBlocks.push_back(node.firstChild);
+        node.firstChild = NONE;
+        ++counters.collapses;
+        current = node.parent;
+    }
+}
+
+void ArenaQuadTree::collectStats(IndexStats &stats) const {
+    stats.counters += counters;
+    collectNodeStats(ROOT, stats);
+}
+void ArenaQuadTree::collectNodeStats(unsigned index, IndexStats &stats) const {
+    const Node &node = nodes[index];
+    ++stats.nodes;
+    if (stats.objectsAtDepth.size() <= node.level)
+        stats.objectsAtDepth.resize(node.level + 1);
+    stats.objectsAtDepth[node.level] += (unsigned)node.objects.size();
+    stats.maxNodeObjects = std::max(stats.maxNodeObjects, (unsigned)node.objects.size());
+    if (node.isLeaf()) {
+        ++stats.leaves;
+        if (node.objects.empty()) ++stats.emptyLeaves;
+        return;
+    }
+    stats.straddlers += (unsigned)node.objects.size();
+    for (unsigned i = 0; i < 4; ++i)
+        collectNodeStats(node.firstChild + i, stats);
+}
+
+// Returns object count of a node and all of its descendants
+unsigned ArenaQuadTree::subtreeObjects(unsigned index) const noexcept {
+    const Node &node = nodes[index];
+    unsigned total = (unsigned)node.objects.size();
+    if (!node.isLeaf()) {
+        for (unsigned i = 0; i < 4; ++i)
+            total += subtreeObjects(node.firstChild + i);
+    }
+    return total;
+}
+
+// Returns index of an unused block of four nodes, reusing freed blocks first
+unsigned ArenaQuadTree::allocateBlock() {
+    if (!freeBlocks.empty()) {
+        unsigned first = freeBlocks.back();
+        freeBlocks.pop_back();
+        return first;
+    }
+    unsigned first = (unsigned)nodes.size();
+    nodes.resize(nodes.size() + 4);
+    return first;
+}
+
+// Returns child of index that contains the provided boundary
+unsigned ArenaQuadTree::getChild(unsigned index, const Rect &bound) const noexcept {
+    const Node &node = nodes[index];
+    unsigned q = quadrant(node.bounds, bound);
+    if (q == NONE) return NONE;
+    unsigned child = node.firstChild + q;
+    if (looseness > 1 && !nodes[child].loose.contains(bound))
+        return NONE;
+    return child;
+}
+
+// Returns which quadrant of bounds the provided boundary goes in. When loose, that
+// is the one holding its center (the caller checks it fits the loose bounds)
+unsigned ArenaQuadTree::quadrant(const Rect &bounds, const Rect &bound) const noexcept {
+    if (looseness > 1) {
+        bool right = bound.x() > bounds.x();
+        return bound.y() > bounds.y() ?
+            (right ? 3 : 2) : // bottom right / bottom left
+            (right ? 0 : 1);  // top right / top left
+    }
+    bool right = bound.left() > bounds.x();
+    bool left = !right && bound.right() < bounds.x();
+
+    if (bound.bottom() > bounds.y()) {
+        if (left)  return 2; // bottom left
+        if (right) return 3; // bottom right
+    } else if (bound.top() < bounds.y()) {
+        if (left)  return 1; // top left
+        if (right) return 0; // top right
+    }
+    return NONE; // Cannot contain boundary -- too large
+}
+
+// Computes the tight and loose bounds of a quadrant of bounds
+void ArenaQuadTree::childBounds(const Rect &bounds, unsigned quadrant, Rect &child, Rect &loose) const noexcept {
+    double hw = bounds.halfWidth();
+    double hh = bounds.halfHeight();
+    double qw = hw * 0.5f;
+    double qh = hh * 0.5f;
+    double x = 0, y = 0;
+    switch (quadrant) {
+        case 0: x = bounds.x() + qw; y = bounds.y() - qh; break; // Top right
+        case 1: x = bounds.x() - qw; y = bounds.y() - qh; break; // Top left
+        case 2: x = bounds.x() - qw; y = bounds.y() + qh; break; // Bottom left
+        case 3: x = bounds.x() + qw; y = bounds.y() + qh; break; // Bottom right
+    }
+    child.update(x, y, hw, hh);
+    loose.update(x, y, hw * looseness, hh * looseness);
+}
+
+//** Node **//
+void ArenaQuadTree::Node::push(Collidable *obj) {
+    objects.push_back(obj);
+    left.push_back((float)obj->bound.left());
+    bottom.push_back((float)obj->bound.bottom());
+    right.push_back((float)obj->bound.right());
+    top.push_back((float)obj->bound.top());
+}
+void ArenaQuadTree::Node::copy(unsigned from, unsigned to) noexcept {
+    objects[to] = objects[from];
+    left[to]    = left[from];
+    bottom[to]  = bottom[from];
+    right[to]   = right[from];
+    top[to]     = top[from];
+}
+void ArenaQuadTree::Node::setBound(unsigned slot, const Rect &bound) noexcept {
+    left[slot]   = (float)bound.left();
+    bottom[slot] = (float)bound.bottom();
+    right[slot]  = (float)bound.right();
+    top[slot]    = (float)bound.top();
+}
+void ArenaQuadTree::Node::resize(unsigned size) noexcept {
+    objects.resize(size);
+    left.resize(size);
+    bottom.resize(size);
+    right.resize(size);
+    top.resize(size);
+}
+
+ArenaQuadTree::~ArenaQuadTree() {
+    clear();
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/***************************************
+QuadTree whose nodes live in one pooled
+array and are linked by 32-bit indices.
+Children are allocated in blocks of four
+and recycled through a free list, so the
+tree does not touch the heap once warm.
+Supports the same loose mode as QuadTree,
+and can be bulk built from Morton-sorted
+objects once per tick (rebuild())
+***************************************/
+
+#pragma once
+#include "SpatialIndex.hpp"
+#include <cstdint>
+
+class ArenaQuadTree final : public SpatialIndex {
+public:
+    ArenaQuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel, double _looseness = 1);
+
+    bool insert(Collidable *obj) override;
+    bool remove(Collidable *obj) noexcept override;
+    bool update(Collidable *obj) override;
+    bool contains(Collidable *obj) const noexcept override;
+    bool touch(Collidable *obj) noexcept override;
+    unsigned totalChildren() const noexcept override;
+    unsigned totalObjects() const noexcept override;
+    const Rect &getBounds() const noexcept override;
+    void clear() noexcept override;
+    void rebuild() override;
+    void collectStats(IndexStats &stats) const override;
+    void getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+        unsigned char types = anyType, double maxDistance = std::numeric_limits<double>::infinity()) const override;
+
+    ~ArenaQuadTree();
+private:
+    static constexpr unsigned NONE = Collidable::NONE;
+    static constexpr unsigned ROOT = 0;
+
+    struct Node {
+        Rect     bounds;
+        Rect     loose;             // bounds scaled by looseness -- what objects in this node must fit in
+        unsigned parent     = NONE;
+        unsigned firstChild = NONE; // Children are stored at firstChild..firstChild+3
+        unsigned level      = 0;
+        unsigned long long changed = 0; // Epoch of the last change to this node or its descendants
+
+        // Objects plus a structure-of-arrays copy of their bounds, so
+        // that a scan can test several boxes per instruction
+        std::vector<Collidable*> objects;
+        std::vector<float> left, bottom, right, top;
+        TypeCounts occupancy; // Objects in this node and its descendants, by type
+
+        bool isLeaf() const noexcept { return firstChild == NONE; }
+        void push(Collidable *obj);
+        void copy(unsigned from, unsigned to) noexcept;
+        void setBound(unsigned slot, const Rect &bound) noexcept;
+        void resize(unsigned size) noexcept;
+    };
+    unsigned capacity          = 0;
+    unsigned maxLevel          = 0;
+    unsigned collapseThreshold = 0; // Subtrees are only merged once they drop to this many objects
+    double   looseness         = 1;
+
+    std::vector<Node>     nodes;
+    std::vector<unsigned> freeBlocks; // First index of each unused block of four children
+
+    // Object plus the Morton code of the node it belongs in (2 bits per level,
+    // most significant first) with that node's level in the low 6 bits. Sorted
+    // by key, every subtree is one run that starts with the node's own objects
+    struct BuildEntry {
+        uint64_t    key;
+        Collidable *obj;
+    };
+    static constexpr unsigned MAX_BUILD_LEVEL = 29; // Levels that fit above the 6 level bits
+    std::vector<BuildEntry> buildEntries, sortBuffer;
+
+    bool visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const override;
+    bool visitNode(unsigned index, const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const;
+    void stamp(unsigned index) noexcept;
+    unsigned locate(unsigned index, const Rect &bound) const noexcept;
+    void attach(unsigned index, Collidable *obj);
+    void detach(Collidable *obj) noexcept;
+    void subdivide(unsigned index);
+    void sortEntries();
+    void build(unsigned index, unsigned begin, unsigned end);
+    void place(unsigned index, Collidable *obj);
+    void collapse(unsigned index) noexcept;
+    unsigned subtreeObjects(unsigned index) const noexcept;
+    void collectNodeStats(unsigned index, IndexStats &stats) const;
+    unsigned allocateBlock();
+    inline unsigned getChild(unsigned index, const Rect &bound) const noexcept;
+    inline unsigned quadrant(const Rect &bounds, const Rect &bound) const noexcept;
+    void childBounds(const Rect &bounds, unsigned quadrant, Rect &child, Rect &loose) const noexcept;
+};
\ No newline at end of file
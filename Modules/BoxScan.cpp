@@ -0,0 +1,57 @@
+#include "BoxScan.hpp"
+#include "CpuFeatures.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BOXSCAN_AVX2 __attribute__((target("avx2")))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define BOXSCAN_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace boxscan {
+
+static uint64_t scanScalar(const float *left, const float *bottom, const float *right, const float *top,
+    unsigned count, float qLeft, float qBottom, float qRight, float qTop) noexcept {
+    uint64_t hits = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        bool overlaps = left[i] <= qRight && right[i] >= qLeft && bottom[i] <= qTop && top[i] >= qBottom;
+        hits |= (uint64_t)overlaps << i;
+    }
+    return hits;
+}
+
+#ifdef BOXSCAN_AVX2
+BOXSCAN_AVX2 static uint64_t scanAVX2(const float *left, const float *bottom, const float *right, const float *top,
+    unsigned count, float qLeft, float qBottom, float qRight, float qTop) noexcept {
+    const __m256 ql = _mm256_set1_ps(qLeft);
+    const __m256 qb = _mm256_set1_ps(qBottom);
+    const __m256 qr = _mm256_set1_ps(qRight);
+    const __m256 qt = _mm256_set1_ps(qTop);
+
+    uint64_t hits = 0;
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 overlaps = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(left + i), qr, _CMP_LE_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(right + i), ql, _CMP_GE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(bottom + i), qt, _CMP_LE_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(top + i), qb, _CMP_GE_OQ)));
+        hits |= (uint64_t)(unsigned)_mm256_movemask_ps(overlaps) << i;
+    }
+    // Remaining boxes (fewer than 8)
+    if (i < count)
+        hits |= scanScalar(left + i, bottom + i, right + i, top + i, count - i, qLeft, qBottom, qRight, qTop) << i;
+    return hits;
+}
+
+const Scanner scan = cpu::hasAVX2() ? scanAVX2 : scanScalar;
+#else
+const Scanner scan = scanScalar;
+#endif
+
+const char *name() noexcept {
+    return scan == scanScalar ? "scalar" : "avx2";
+}
+
+} // namespace boxscan
\ No newline at end of file
@@ -0,0 +1,37 @@
+/***************************************
+Overlap tests for boxes stored as four
+separate arrays of edges. The AVX2 path
+tests 8 boxes per instruction and is
+picked at startup when the CPU has it
+***************************************/
+
+#pragma once
+#include <cstdint>
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace boxscan {
+
+// Returns a mask with bit i set for every box i in [0, count) that
+// overlaps the query box. count may be at most 64
+using Scanner = uint64_t(*)(const float *left, const float *bottom, const float *right, const float *top,
+    unsigned count, float qLeft, float qBottom, float qRight, float qTop) noexcept;
+
+extern const Scanner scan;
+
+// Name of the implementation scan points to ("avx2" or "scalar")
+const char *name() noexcept;
+
+// Index of the lowest set bit of a non-zero mask
+inline unsigned lowestBit(uint64_t mask) noexcept {
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return (unsigned)index;
+    #else
+        return (unsigned)__builtin_ctzll(mask);
+    #endif
+}
+
+} // namespace boxscan
\ No newline at end of file
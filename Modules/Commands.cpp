@@ -10,6 +10,7 @@
 #include "../Entities/Ejected.hpp"
 #include "../Entities/MotherCell.hpp"
 #include "../Entities/PlayerCell.hpp"
+#include "MoveKernel.hpp"
 
 Commands::Commands(Game *_game) :
     game(_game) {
@@ -219,6 +220,16 @@ void Commands::exit(const std::vector<json> &args) {
     game->state = GameState::ENDED;
 }
 
+// Despawns every entity of a type. Despawned entities stay in the
+// vector until the end of the tick, so walk it rather than pop it
+static void despawnAll(int type) {
+    std::vector<Entity*> &vec = map::entities[type];
+    for (size_t i = 0; i < vec.size(); ++i) {
+        if (!(vec[i]->state() & isRemoved))
+            map::despawn(vec[i]);
+    }
+}
+
 void Commands::despawn(const std::vector<json> &args) {
     if (args.size() > 1 || (args.size() == 1 && !args[0].is_string()))
         throw "Invalid arguments.";
@@ -237,36 +248,31 @@ void Commands::despawn(const std::vector<json> &args) {
 
     if (type == "food" || type == "all") {
         cfg::food_startAmount = 0;
-        Logger::info("Despawning ", map::entities[Food::TYPE].size(), " food.");
-        while (!map::entities[Food::TYPE].empty())
-            map::despawn(map::entities[Food::TYPE].back());
+        Logger::info("Despawning ", map::count(Food::TYPE), " food.");
+        despawnAll(Food::TYPE);
         cfg::food_startAmount = tempStartAmount;
     }
     if (type == "viruses" || type == "all") {
         tempStartAmount = cfg::virus_startAmount;
         cfg::virus_startAmount = 0;
-        Logger::info("Despawning ", map::entities[Virus::TYPE].size(), " viruses.");
-        while (!map::entities[Virus::TYPE].empty())
-            map::despawn(map::entities[Virus::TYPE].back());
+        Logger::info("Despawning ", map::count(Virus::TYPE), " viruses.");
+        despawnAll(Virus::TYPE);
         cfg::virus_startAmount = tempStartAmount;
     }
     if (type == "ejected" || type == "all") {
-        Logger::info("Despawning ", map::entities[Ejected::TYPE].size(), " ejected.");
-        while (!map::entities[Ejected::TYPE].empty())
-            map::despawn(map::entities[Ejected::TYPE].back());
+        Logger::info("Despawning ", map::count(Ejected::TYPE), " ejected.");
+        despawnAll(Ejected::TYPE);
     }
     if (type == "mothercells" || type == "all") {
         tempStartAmount = cfg::motherCell_startAmount;
         cfg::motherCell_startAmount = 0;
-        Logger::info("Despawning ", map::entities[MotherCell::TYPE].size(), " mothercells.");
-        while (!map::entities[MotherCell::TYPE].empty())
-            map::despawn(map::entities[MotherCell::TYPE].back());
+        Logger::info("Despawning ", map::count(MotherCell::TYPE), " mothercells.");
+        despawnAll(MotherCell::TYPE);
         cfg::motherCell_startAmount = tempStartAmount;
     }
     if (type == "playercells" || type == "all") {
-        Logger::info("Despawning ", map::entities[PlayerCell::TYPE].size(), " playercells.");
-        while (!map::entities[PlayerCell::TYPE].empty())
-            map::despawn(map::entities[PlayerCell::TYPE].back());
+        Logger::info("Despawning ", map::count(PlayerCell::TYPE), " playercells.");
+        despawnAll(PlayerCell::TYPE);
     }
 }
 
@@ -377,7 +383,7 @@ void Commands::setposition(const std::vector<json> &args) {
     if (x < bounds.left() || x > bounds.right() || y < bounds.bottom() || y > bounds.top())
         throw "Position is out of bounds.";
 
-    for (sptr<PlayerCell::Entity> cell : player->cells)
+    for (Entity *cell : player->cells)
         cell->setPosition({ x, y });
 
     Logger::print("Set position of " + player->cellNameUTF8() + " to "
@@ -434,8 +440,8 @@ void Commands::pop(const std::vector<json> &args) {
     if (player->state() != PlayerState::PLAYING)
         throw "Player is not in-game.";
 
-    sptr<PlayerCell::Entity> biggestCell = player->cells[0];
-    for (sptr<PlayerCell::Entity> cell : player->cells) {
+    Entity *biggestCell = player->cells[0];
+    for (Entity *cell : player->cells) {
         if (cell->radius() > biggestCell->radius())
             biggestCell = cell;
     }
@@ -486,7 +492,7 @@ void Commands::setmass(const std::vector<json> &args) {
         throw "Mass cannot be zero.";
 
     float avgMass = args[1].get<float>() / player->cells.size();
-    for (sptr<PlayerCell::Entity> cell : player->cells)
+    for (Entity *cell : player->cells)
         cell->setMass(avgMass);
 
     Logger::print("Set mass of " + player->cellNameUTF8() + " to " + args[1].dump(), '\n');
@@ -551,10 +557,10 @@ void Commands::explode(const std::vector<json> &args) {
     float ejectedBaseMass = utils::toMass(cfg::ejected_baseRadius);
     int amountOfEjected;
 
-    for (sptr<PlayerCell::Entity> cell : player->cells) {
+    for (Entity *cell : player->cells) {
         amountOfEjected = (int)std::ceil(cell->mass() / ejectedBaseMass);
         for (; amountOfEjected > 0; --amountOfEjected) {
-            sptr<Ejected> e = map::spawn<Ejected>(cell->position(), cfg::ejected_baseRadius, cell->color());
+            Ejected *e = map::spawn<Ejected>(cell->position(), cfg::ejected_baseRadius, cell->color());
             e->setCreator(cell->nodeId());
             e->setVelocity(
                 (float)rand(1.0, (double)cfg::ejected_initialAcceleration * 2),
@@ -573,7 +579,7 @@ void Commands::speed(const std::vector<json> &args) {
         throw 0;
 
     Player *player = getPlayer(args[0]);
-    for (sptr<PlayerCell::Entity> cell : player->cells)
+    for (Entity *cell : player->cells)
         cell->speedMultiplier = args[1];
 
     Logger::info("Set speed multiplier of " + player->cellNameUTF8() + " to " + args[1].dump());
@@ -594,7 +600,7 @@ void Commands::color(const std::vector<json> &args) {
         throw "Player is not in-game.";
 
     Color newColor(args[1], args[2], args[3]);
-    for (sptr<PlayerCell::Entity> cell : player->cells)
+    for (Entity *cell : player->cells)
         cell->setColor(newColor);
 
     Logger::info("Set color of " + player->cellNameUTF8() + " to " + newColor.toString());
@@ -637,7 +643,7 @@ void Commands::replace(const std::vector<json> &args) {
         throw "Player is not in-game.";
 
     while (!player->cells.empty()) {
-        e_ptr cell = player->cells.back();
+        Entity *cell = player->cells.back();
         if (type == "mothercell")
             map::spawn<MotherCell>(cell->position(), cell->radius(), cell->color(), false);
         else if (type == "virus")
@@ -755,6 +761,10 @@ void Commands::setconfig(const std::vector<json> &args) {
         config[args[0].get<std::string>()][args[1].get<std::string>()] = args[2];
 
     game->loadConfig(); // Reload config
+
+    // player.baseRemergeTime may have changed, which moves every cell's remerge time
+    for (Entity *cell : map::entities[PlayerCell::TYPE])
+        static_cast<PlayerCell*>(cell)->checkRemerge();
 }
 
 void Commands::debug(const std::vector<json> &args) {
@@ -774,18 +784,103 @@ void Commands::debug(const std::vector<json> &args) {
     Logger::info();
     Logger::info("Average player score: ", avgScore);
     Logger::info();
-    Logger::info("Food: ", map::entities[Food::TYPE].size());
-    Logger::info("Viruses: ", map::entities[Virus::TYPE].size());
-    Logger::info("Ejected: ", map::entities[Ejected::TYPE].size());
-    Logger::info("MotherCells: ", map::entities[MotherCell::TYPE].size());
-    Logger::info("PlayerCells: ", map::entities[PlayerCell::TYPE].size());
-    Logger::info("Total quadTree objects: ", map::quadTree.totalObjects());
-    Logger::info("Total quadTree children: ", map::quadTree.totalChildren());
+    Logger::info("Food: ", map::count(Food::TYPE));
+    Logger::info("Viruses: ", map::count(Virus::TYPE));
+    Logger::info("Ejected: ", map::count(Ejected::TYPE));
+    Logger::info("MotherCells: ", map::count(MotherCell::TYPE));
+    Logger::info("PlayerCells: ", map::count(PlayerCell::TYPE));
+    Logger::info("Pending timers: ", map::pendingTimers());
+    Logger::info("Moving entities: ", map::movingEntities.size(), " (peak since last debug: ", map::movingPeak, ")");
+    map::movingPeak = (unsigned)map::movingEntities.size();
+    Logger::info("Entity pools (alive / slots, high-water mark):");
+    const char *poolNames[] = { "Food", "Viruses", "Ejected", "MotherCells", "PlayerCells" };
+    for (int type = Food::TYPE; type <= PlayerCell::TYPE; ++type) {
+        const SlabBase<Entity> &pool = map::pool(type);
+        Logger::info("  ", poolNames[type], ": ", pool.size(), " / ", pool.capacity(), ", ", pool.highWater());
+    }
+    Logger::info("PlayerCell movement kernel: ", movekernel::name());
+    Logger::info("Collision threads: ", map::collisionThreads());
+    Logger::info("Cached contacts: ", map::cachedContacts());
+    Logger::info("Total quadTree objects: ", map::quadTree->totalObjects());
+    Logger::info("Total quadTree children: ", map::quadTree->totalChildren());
+    Logger::info("Static index objects: ", map::quadTree->staticPart().totalObjects(),
+        ", dynamic index objects: ", map::quadTree->dynamicPart().totalObjects());
+    Logger::info("Spatial index update mode: ", map::rebuildIndex ? "rebuild" : "incremental");
+    const map::IndexUpdateCost &cost = map::indexUpdateCost;
+    if (cost.incremental >= 0 && cost.rebuild >= 0) {
+        Logger::info("Sampled index update cost per tick: incremental ", cost.incremental, "us, rebuild ",
+            cost.rebuild, "us (", cost.incremental <= cost.rebuild ? "incremental" : "rebuild", " is cheaper)");
+    }
     Logger::info();
     Logger::info("Current game tick: ", game->tickCount);
     Logger::info("Update time for Game::mainLoop(): ", game->updateTime, "ms");
 }
 
+void Commands::quadtree(const std::vector<json> &args) {
+    if (!args.empty()) throw "'quadtree' takes zero arguments.";
+
+    IndexStats stats;
+    map::quadTree->collectStats(stats);
+    const map::CollisionCounters &collisions = map::collisionCounters;
+    auto ratio = [](double a, double b) { return b > 0 ? std::round(a / b * 100) / 100 : 0.0; };
+    auto percent = [&ratio](double a, double b) { return ratio(a * 100, b); };
+
+    unsigned objects = map::quadTree->totalObjects();
+    unsigned long long ticks = game->tickCount - lastStatsTick;
+    IndexCounters delta = stats.counters;
+    delta.subdivisions -= lastIndexCounters.subdivisions;
+    delta.collapses    -= lastIndexCounters.collapses;
+    delta.queries      -= lastIndexCounters.queries;
+    delta.examined     -= lastIndexCounters.examined;
+    delta.returned     -= lastIndexCounters.returned;
+    unsigned long long collisionQueries    = collisions.queries - lastCollisionQueries;
+    unsigned long long collisionCandidates = collisions.candidates - lastCollisionCandidates;
+    unsigned long long collisionHits       = collisions.hits - lastCollisionHits;
+    unsigned long long contacts            = collisions.contacts - lastContacts;
+    unsigned long long warmContacts        = collisions.warm - lastWarmContacts;
+    unsigned long long restingContacts     = collisions.resting - lastRestingContacts;
+
+    Logger::info("Spatial index: ", cfg::game_spatialIndex, " (", map::rebuildIndex ? "rebuild" : "incremental",
+        " update mode)");
+    Logger::info("Objects: ", objects, " (static ", map::quadTree->staticPart().totalObjects(),
+        ", dynamic ", map::quadTree->dynamicPart().totalObjects(), ")");
+    Logger::info("Nodes: ", stats.nodes, ", leaves: ", stats.leaves, " (", stats.emptyLeaves, " empty)");
+    Logger::info("Objects per leaf: ", ratio(objects - stats.straddlers, stats.leaves - stats.emptyLeaves),
+        " average (non-empty leaves), ", stats.maxNodeObjects, " most in one node");
+    Logger::info("Straddlers (objects kept above the leaves): ", stats.straddlers, " (",
+        percent(stats.straddlers, objects), "%)");
+    Logger::info("Objects at depth:");
+    unsigned widest = 1;
+    for (unsigned count : stats.objectsAtDepth) widest = std::max(widest, count);
+    for (unsigned depth = 0; depth < stats.objectsAtDepth.size(); ++depth) {
+        unsigned count = stats.objectsAtDepth[depth];
+        Logger::info("  ", depth, ": ", count, "\t", std::string(count * 40 / widest, '#'));
+    }
+    Logger::info();
+    Logger::info("Over the last ", ticks, " ticks:");
+    Logger::info("Subdivisions per tick: ", ratio((double)delta.subdivisions, (double)ticks),
+        ", collapses per tick: ", ratio((double)delta.collapses, (double)ticks));
+    Logger::info("Bound queries: ", delta.queries, ", objects examined per query: ",
+        ratio((double)delta.examined, (double)delta.queries), ", returned per query: ",
+        ratio((double)delta.returned, (double)delta.queries));
+    Logger::info("Collision queries: ", collisionQueries, ", candidates per query: ",
+        ratio((double)collisionCandidates, (double)collisionQueries), ", true hits per query: ",
+        ratio((double)collisionHits, (double)collisionQueries), " (",
+        percent((double)collisionHits, (double)collisionCandidates), "% of candidates)");
+    Logger::info("Contacts: ", contacts, ", warm started: ", warmContacts, " (",
+        percent((double)warmContacts, (double)contacts), "%), resting skipped: ", restingContacts, " (",
+        percent((double)restingContacts, (double)contacts), "%)");
+
+    lastIndexCounters       = stats.counters;
+    lastCollisionQueries    = collisions.queries;
+    lastCollisionCandidates = collisions.candidates;
+    lastCollisionHits       = collisions.hits;
+    lastContacts            = collisions.contacts;
+    lastWarmContacts        = collisions.warm;
+    lastRestingContacts     = collisions.resting;
+    lastStatsTick           = game->tickCount;
+}
+
 void Commands::help(const std::vector<json> &args) {
     if (!args.empty()) throw "'help' takes zero arguments.";
 
@@ -843,6 +938,8 @@ void Commands::help(const std::vector<json> &args) {
         "\n| setconfig, sc <group> <name> <value> Sets value of config[group][name]             |"
         "\n| debug                                Prints amount of players, entities, and the   |"
         "\n|                                      update time for Game::mainLoop()              |"
+        "\n| quadtree, qt                         Prints spatial index shape and query metrics  |"
+        "\n|                                      since the previous call                       |"
         "\n| help                                 Prints a list of all commands + agruments     |"
         "\n|                                                                                    |"
         "\n+------------------------------------------------------------------------------------+"
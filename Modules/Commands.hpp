@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include "Utils.hpp"
+#include "SpatialIndex.hpp"
 
 // Forward declarations
 class Game;
@@ -47,6 +48,7 @@ struct Commands {
     void getconfig(const std::vector<json> &args);
     void setconfig(const std::vector<json> &args);
     void debug(const std::vector<json> &args);
+    void quadtree(const std::vector<json> &args);
     void help(const std::vector<json> &args);
     
     ~Commands();
@@ -102,7 +104,15 @@ private:
         { "setconfig", &Commands::setconfig },
         { "sc", &Commands::setconfig },
         { "debug", &Commands::debug },
+        { "quadtree", &Commands::quadtree },
+        { "qt", &Commands::quadtree },
         { "help", &Commands::help }
     };
     Game *game = nullptr;
+
+    // Totals as of the previous 'quadtree' command, so rates cover the ticks since
+    IndexCounters lastIndexCounters;
+    unsigned long long lastCollisionQueries = 0, lastCollisionCandidates = 0, lastCollisionHits = 0;
+    unsigned long long lastContacts = 0, lastWarmContacts = 0, lastRestingContacts = 0;
+    unsigned long long lastStatsTick = 0;
 };
\ No newline at end of file
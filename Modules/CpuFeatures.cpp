@@ -0,0 +1,31 @@
+#include "CpuFeatures.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h> // _xgetbv
+    #include <intrin.h>
+#endif
+
+namespace cpu {
+
+bool hasAVX2() noexcept {
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        // Callers pick kernels during static initialization, which may run
+        // before the runtime has filled in what __builtin_cpu_supports reads
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false; // OS must save YMM state
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        return false;
+    #endif
+}
+
+} // namespace cpu
@@ -0,0 +1,14 @@
+/***************************************
+Runtime checks for optional instruction
+sets, so SIMD paths can be picked once
+at startup
+***************************************/
+
+#pragma once
+
+namespace cpu {
+
+// Whether the CPU and OS support AVX2
+bool hasAVX2() noexcept;
+
+} // namespace cpu
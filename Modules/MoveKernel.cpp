@@ -0,0 +1,138 @@
+#include "MoveKernel.hpp"
+#include "CpuFeatures.hpp"
+#include <cmath>     // std::sqrt
+#include <algorithm> // std::min
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define MOVEKERNEL_AVX2 __attribute__((target("avx2")))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define MOVEKERNEL_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace movekernel {
+
+static void moveScalar(double *x, double *y, double *vx, double *vy, const float *radius,
+    const double *targetX, const double *targetY, const float *step, unsigned char *moved,
+    unsigned count, const Border &border) noexcept {
+    for (unsigned i = 0; i < count; ++i) {
+        moved[i] = 0;
+
+        // Difference between centers
+        double dx = (int)(targetX[i] - x[i]);
+        double dy = (int)(targetY[i] - y[i]);
+        double distance = dx * dx + dy * dy;
+
+        // Not enough of a difference to move
+        if (distance <= 1) continue;
+
+        // Limit the speed and check > 0 to prevent jittering
+        distance = std::sqrt(distance);
+        double speed = std::min(distance, (double)step[i]) / distance;
+        if (!(speed > 0)) continue;
+        x[i] += dx * speed;
+        y[i] += dy * speed;
+        moved[i] = 1;
+
+        // Bounce off of map borders
+        const float hr = radius[i] * 0.5f; // half radius
+        double maxIndent = border.left + hr;
+        if (x[i] <= maxIndent) {
+            x[i] = maxIndent;
+            vx[i] = -vx[i];
+        }
+        if ((maxIndent = border.right - hr) < x[i]) {
+            x[i] = maxIndent;
+            vx[i] = -vx[i];
+        }
+        if ((maxIndent = border.bottom + hr) > y[i]) {
+            y[i] = maxIndent;
+            vy[i] = -vy[i];
+        }
+        if ((maxIndent = border.top - hr) < y[i]) {
+            y[i] = maxIndent;
+            vy[i] = -vy[i];
+        }
+    }
+}
+
+#ifdef MOVEKERNEL_AVX2
+MOVEKERNEL_AVX2 static void moveAVX2(double *x, double *y, double *vx, double *vy, const float *radius,
+    const double *targetX, const double *targetY, const float *step, unsigned char *moved,
+    unsigned count, const Border &border) noexcept {
+    const __m256d one    = _mm256_set1_pd(1.0);
+    const __m256d zero   = _mm256_setzero_pd();
+    const __m256d sign   = _mm256_set1_pd(-0.0);
+    const __m256d left   = _mm256_set1_pd(border.left);
+    const __m256d right  = _mm256_set1_pd(border.right);
+    const __m256d bottom = _mm256_set1_pd(border.bottom);
+    const __m256d top    = _mm256_set1_pd(border.top);
+    const __m128  half   = _mm_set1_ps(0.5f);
+
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d px = _mm256_loadu_pd(x + i);
+        __m256d py = _mm256_loadu_pd(y + i);
+        __m256d dx = _mm256_round_pd(_mm256_sub_pd(_mm256_loadu_pd(targetX + i), px),
+            _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256d dy = _mm256_round_pd(_mm256_sub_pd(_mm256_loadu_pd(targetY + i), py),
+            _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256d distanceSquared = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        __m256d distance = _mm256_sqrt_pd(distanceSquared);
+
+        // Lanes that do not move divide by zero here, and are masked out below
+        __m256d speed = _mm256_div_pd(_mm256_min_pd(distance, _mm256_cvtps_pd(_mm_loadu_ps(step + i))), distance);
+        __m256d moving = _mm256_and_pd(_mm256_cmp_pd(distanceSquared, one, _CMP_GT_OQ),
+                                       _mm256_cmp_pd(speed, zero, _CMP_GT_OQ));
+        __m256d nx = _mm256_add_pd(px, _mm256_mul_pd(dx, speed));
+        __m256d ny = _mm256_add_pd(py, _mm256_mul_pd(dy, speed));
+
+        // Bounce off of map borders, in the same order as the scalar path
+        __m256d hr = _mm256_cvtps_pd(_mm_mul_ps(_mm_loadu_ps(radius + i), half));
+        __m256d flipX = _mm256_setzero_pd(), flipY = _mm256_setzero_pd();
+        __m256d edge = _mm256_add_pd(left, hr);
+        __m256d hit = _mm256_cmp_pd(nx, edge, _CMP_LE_OQ);
+        nx = _mm256_blendv_pd(nx, edge, hit);
+        flipX = _mm256_xor_pd(flipX, hit);
+        edge = _mm256_sub_pd(right, hr);
+        hit = _mm256_cmp_pd(edge, nx, _CMP_LT_OQ);
+        nx = _mm256_blendv_pd(nx, edge, hit);
+        flipX = _mm256_xor_pd(flipX, hit);
+        edge = _mm256_add_pd(bottom, hr);
+        hit = _mm256_cmp_pd(edge, ny, _CMP_GT_OQ);
+        ny = _mm256_blendv_pd(ny, edge, hit);
+        flipY = _mm256_xor_pd(flipY, hit);
+        edge = _mm256_sub_pd(top, hr);
+        hit = _mm256_cmp_pd(edge, ny, _CMP_LT_OQ);
+        ny = _mm256_blendv_pd(ny, edge, hit);
+        flipY = _mm256_xor_pd(flipY, hit);
+
+        // Flipping the sign bit reverses a velocity
+        flipX = _mm256_and_pd(_mm256_and_pd(flipX, moving), sign);
+        flipY = _mm256_and_pd(_mm256_and_pd(flipY, moving), sign);
+        _mm256_storeu_pd(vx + i, _mm256_xor_pd(_mm256_loadu_pd(vx + i), flipX));
+        _mm256_storeu_pd(vy + i, _mm256_xor_pd(_mm256_loadu_pd(vy + i), flipY));
+        _mm256_storeu_pd(x + i, _mm256_blendv_pd(px, nx, moving));
+        _mm256_storeu_pd(y + i, _mm256_blendv_pd(py, ny, moving));
+
+        int mask = _mm256_movemask_pd(moving);
+        for (unsigned lane = 0; lane < 4; ++lane)
+            moved[i + lane] = (unsigned char)((mask >> lane) & 1);
+    }
+    // Remaining cells (fewer than 4)
+    if (i < count)
+        moveScalar(x + i, y + i, vx + i, vy + i, radius + i, targetX + i, targetY + i, step + i, moved + i,
+            count - i, border);
+}
+
+const Mover move = cpu::hasAVX2() ? moveAVX2 : moveScalar;
+#else
+const Mover move = moveScalar;
+#endif
+
+const char *name() noexcept {
+    return move == moveScalar ? "scalar" : "avx2";
+}
+
+} // namespace movekernel
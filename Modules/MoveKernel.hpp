@@ -0,0 +1,33 @@
+/***************************************
+Batch movement of cells toward targets,
+over positions stored as separate arrays.
+The AVX2 path moves 4 cells per
+instruction and is picked at startup
+when the CPU has it
+***************************************/
+
+#pragma once
+
+namespace movekernel {
+
+// Edges cells are kept within
+struct Border {
+    double left, bottom, right, top;
+};
+
+// For each cell i in [0, count):
+// - moves it toward (targetX[i], targetY[i]) by at most step[i] units,
+//   unless the truncated offset to the target is 1 unit or less
+// - clamps moved cells inside border, shrunk by half their radius,
+//   reversing their velocity on each edge they hit
+// - sets moved[i] to 1 if the cell moved, 0 if not
+using Mover = void(*)(double *x, double *y, double *vx, double *vy, const float *radius,
+    const double *targetX, const double *targetY, const float *step, unsigned char *moved,
+    unsigned count, const Border &border) noexcept;
+
+extern const Mover move;
+
+// Name of the implementation move points to ("avx2" or "scalar")
+const char *name() noexcept;
+
+} // namespace movekernel
@@ -0,0 +1,124 @@
+#include "PartitionedIndex.hpp"
+#include <algorithm> // PartitionedIndex::getNearestObjects()
+
+PartitionedIndex::PartitionedIndex(std::unique_ptr<SpatialIndex> _staticIndex,
+    std::unique_ptr<SpatialIndex> _dynamicIndex, unsigned char _staticTypes) :
+    staticIndex(std::move(_staticIndex)),
+    dynamicIndex(std::move(_dynamicIndex)),
+    staticTypes(_staticTypes) {
+}
+
+// Inserts objects of the static types into the static index, the rest into the dynamic one
+bool PartitionedIndex::insert(Collidable *obj) {
+    if (contains(obj)) return false;
+    return (obj->flag & staticTypes) ? staticIndex->insert(obj) : dynamicIndex->insert(obj);
+}
+
+bool PartitionedIndex::remove(Collidable *obj) noexcept {
+    return staticIndex->remove(obj) || dynamicIndex->remove(obj);
+}
+
+// Updates object in whichever index holds it
+bool PartitionedIndex::update(Collidable *obj) {
+    if (staticIndex->contains(obj))
+        return staticIndex->update(obj);
+    return dynamicIndex->update(obj);
+}
+
+bool PartitionedIndex::contains(Collidable *obj) const noexcept {
+    return staticIndex->contains(obj) || dynamicIndex->contains(obj);
+}
+
+bool PartitionedIndex::touch(Collidable *obj) noexcept {
+    return staticIndex->touch(obj) || dynamicIndex->touch(obj);
+}
+
+void PartitionedIndex::setMoving(Collidable *obj) {
+    if (!staticIndex->remove(obj)) return; // Already dynamic (or not indexed)
+    dynamicIndex->insert(obj);
+}
+
+void PartitionedIndex::setResting(Collidable *obj) {
+    if (!(obj->flag & staticTypes) || !dynamicIndex->remove(obj)) return;
+    staticIndex->insert(obj);
+}
+
+bool PartitionedIndex::isStatic(Collidable *obj) const noexcept {
+    return staticIndex->contains(obj);
+}
+
+// Walks the dynamic index, then the static one if it can hold any of types
+bool PartitionedIndex::visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    auto forward = [visit, context](Collidable *obj) { return visit(obj, context); };
+    if (!dynamicIndex->forEachChangedInBound(bound, since, types, forward))
+        return false;
+    if (!matches(staticTypes, types))
+        return true;
+    return staticIndex->forEachChangedInBound(bound, since, types, forward);
+}
+
+// Takes the k nearest from each index and merges them, both being sorted nearest first
+void PartitionedIndex::getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+    unsigned char types, double maxDistance) const {
+    size_t begin = out.size();
+    dynamicIndex->getNearestObjects(x, y, k, out, types, maxDistance);
+    if (!matches(staticTypes, types))
+        return;
+    size_t middle = out.size();
+    staticIndex->getNearestObjects(x, y, k, out, types, maxDistance);
+    if (middle == begin || middle == out.size())
+        return; // Only one of them found anything
+    std::inplace_merge(out.begin() + begin, out.begin() + middle, out.end(), [x, y](Collidable *a, Collidable *b) {
+        return a->bound.distanceSquared(x, y) < b->bound.distanceSquared(x, y);
+    });
+    if (out.size() > begin + k)
+        out.resize(begin + k);
+}
+
+// Returns total node (or cell) count of both indexes
+unsigned PartitionedIndex::totalChildren() const noexcept {
+    return staticIndex->totalChildren() + dynamicIndex->totalChildren();
+}
+
+// Returns total object count of both indexes
+unsigned PartitionedIndex::totalObjects() const noexcept {
+    return staticIndex->totalObjects() + dynamicIndex->totalObjects();
+}
+
+// Sums both indexes. Each query reaches both of them, so the
+// query count is this index's own rather than their sum
+void PartitionedIndex::collectStats(IndexStats &stats) const {
+    unsigned long long queries = stats.counters.queries;
+    staticIndex->collectStats(stats);
+    dynamicIndex->collectStats(stats);
+    stats.counters.queries = queries + counters.queries;
+}
+
+const Rect &PartitionedIndex::getBounds() const noexcept {
+    return staticIndex->getBounds();
+}
+
+void PartitionedIndex::clear() noexcept {
+    staticIndex->clear();
+    dynamicIndex->clear();
+}
+
+void PartitionedIndex::setEpoch(unsigned long long _epoch) noexcept {
+    epoch = _epoch;
+    staticIndex->setEpoch(_epoch);
+    dynamicIndex->setEpoch(_epoch);
+}
+
+// Static objects are always updated in place, so only the dynamic index needs rebuilding
+void PartitionedIndex::rebuild() {
+    dynamicIndex->rebuild();
+}
+
+const SpatialIndex &PartitionedIndex::staticPart() const noexcept {
+    return *staticIndex;
+}
+
+const SpatialIndex &PartitionedIndex::dynamicPart() const noexcept {
+    return *dynamicIndex;
+}
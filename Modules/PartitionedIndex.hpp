@@ -0,0 +1,53 @@
+/***************************************
+Pair of spatial indexes queried as one.
+Objects of the static types (food and
+resting viruses/mothercells) sit in a
+static index that only changes when they
+spawn, despawn or resize. Anything that
+moves lives in a small dynamic index, so
+movers never reshape the static one
+***************************************/
+
+#pragma once
+#include "SpatialIndex.hpp"
+#include <memory>
+
+class PartitionedIndex final : public SpatialIndex {
+public:
+    PartitionedIndex(std::unique_ptr<SpatialIndex> _staticIndex, std::unique_ptr<SpatialIndex> _dynamicIndex,
+        unsigned char _staticTypes);
+
+    bool insert(Collidable *obj) override;
+    bool remove(Collidable *obj) noexcept override;
+    bool update(Collidable *obj) override;
+    bool contains(Collidable *obj) const noexcept override;
+    bool touch(Collidable *obj) noexcept override;
+    unsigned totalChildren() const noexcept override;
+    unsigned totalObjects() const noexcept override;
+    const Rect &getBounds() const noexcept override;
+    void clear() noexcept override;
+    void rebuild() override;
+    void collectStats(IndexStats &stats) const override;
+    void setEpoch(unsigned long long _epoch) noexcept override;
+    void getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+        unsigned char types = anyType, double maxDistance = std::numeric_limits<double>::infinity()) const override;
+
+    // Moves an object of a static type to the dynamic index before it starts
+    // moving, and back once it comes to rest. Other objects are left as is
+    void setMoving(Collidable *obj);
+    void setResting(Collidable *obj);
+
+    // Whether obj is held by the static index (and so is never rebuilt)
+    bool isStatic(Collidable *obj) const noexcept;
+
+    const SpatialIndex &staticPart() const noexcept;
+    const SpatialIndex &dynamicPart() const noexcept;
+
+private:
+    std::unique_ptr<SpatialIndex> staticIndex;
+    std::unique_ptr<SpatialIndex> dynamicIndex;
+    unsigned char staticTypes = 0;
+
+    bool visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const override;
+};
@@ -1,171 +1,146 @@
 #include "QuadTree.hpp"
-#include <algorithm> // QuadTree::remove()
-#include <assert.h>  // Rect::Rect()
-
-//** Rect **//
-Rect::Rect(const Rect &other) noexcept :
-    Rect(other._x, other._y, other._width, other._height) { 
-}
-Rect::Rect(const std::initializer_list<double> &points) {
-    assert(points.size() != 3); // Initializer list may only contain 4 doubles.
-    update(*points.begin(), *(points.begin()+1), *(points.begin()+2), *(points.begin()+3));
-}
-Rect::Rect(double X, double Y, double Width, double Height) noexcept {
-    update(X, Y, Width, Height);
-}
-
-void Rect::setPosition(double X, double Y) noexcept {
-    _x = X;
-    _y = Y;
-    updateEndpoints();
-}
-void Rect::setSize(double Width, double Height) noexcept {
-    _width = Width;
-    _height = Height;
-    _halfWidth = Width * 0.5f;
-    _halfHeight = Height * 0.5f;
-    updateEndpoints();
-}
-void Rect::update(double X, double Y, double Width, double Height) noexcept {
-    _x = X;
-    _y = Y;
-    setSize(Width, Height);
-}
-
-double Rect::x() const noexcept { return _x; }
-double Rect::y() const noexcept { return _y; }
-double Rect::width() const noexcept { return _width; }
-double Rect::height() const noexcept { return _height; }
-double Rect::halfWidth() const noexcept { return _halfWidth; }
-double Rect::halfHeight() const noexcept { return _halfHeight; }
-double Rect::left() const noexcept { return _left; }
-double Rect::top() const noexcept { return _top; }
-double Rect::right() const noexcept { return _right; }
-double Rect::bottom() const noexcept { return _bottom; }
-
-// For map in which X increases from left to right and Y increases from bottom to top
-bool Rect::contains(const Rect &other) const noexcept {
-    if (other._left   < _left)   return false;
-    if (other._top    > _top)    return false;
-    if (other._right  > _right)  return false;
-    if (other._bottom < _bottom) return false;
-    return true; // inside bounds
-}
-bool Rect::intersects(const Rect &other) const noexcept {
-    if (std::abs(_x - other._x) * 2 > _width + other._width) return false;
-    if (std::abs(_y - other._y) * 2 > _height + other._height) return false;
-    return true; // intersection
-}
-
-void Rect::updateEndpoints() noexcept {
-    _left   = _x - _halfWidth;
-    _top    = _y + _halfHeight;
-    _right  = _x + _halfWidth;
-    _bottom = _y - _halfHeight;
-}
-
-//** Collidable **//
-Collidable::Collidable(const Rect &_bounds, std::any _data) :
-    bound(_bounds),
-    data(_data) {
-}
+#include <algorithm> // QuadTree::QuadTree(), QuadTree::collectStats()
+#include <queue>     // QuadTree::getNearestObjects()
 
 //** QuadTree **//
 QuadTree::QuadTree() : 
     QuadTree({}, 0, 0) { 
 }
 QuadTree::QuadTree(const QuadTree &other) : 
-    QuadTree(other.bounds, other.capacity, other.maxLevel) { 
+    QuadTree(other.bounds, other.capacity, other.maxLevel, other.looseness) { 
 }
-QuadTree::QuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel) :
+QuadTree::QuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel, double _looseness) :
     bounds(_bound),
+    loose(_bound.x(), _bound.y(), _bound.width() * std::max(_looseness, 1.0), _bound.height() * std::max(_looseness, 1.0)),
+    looseness(std::max(_looseness, 1.0)),
     capacity(_capacity),
     maxLevel(_maxLevel) {
     objects.reserve(_capacity);
-    foundObjects.reserve(_capacity);
 }
 
 // Inserts an object into this quadtree
 bool QuadTree::insert(Collidable *obj) {
     if (obj->qt != nullptr) return false;
 
-    if (!isLeaf) {
-        // insert object into leaf
-        if (QuadTree *child = getChild(obj->bound))
-            return child->insert(obj);
-    }
-    objects.push_back(obj);
-    obj->qt = this;
-
-    // Subdivide if required
-    if (isLeaf && level < maxLevel && objects.size() >= capacity) {
-        subdivide();
-        update(obj);
+    // Find the deepest node that can contain the object
+    QuadTree *target = this;
+    while (!target->isLeaf) {
+        QuadTree *child = target->getChild(obj->bound);
+        if (child == nullptr) break;
+        target = child;
     }
+    target->attach(obj);
     return true;
 }
 
 // Removes an object from this quadtree
 bool QuadTree::remove(Collidable *obj) noexcept {
-    if (obj->qt == nullptr)
+    if (!contains(obj))
         return false; // Cannot exist in vector
-    if (obj->qt != this)
-        return obj->qt->remove(obj);
-
-    auto index = std::find(objects.begin(), objects.end(), obj);
 
-    if (index == objects.end())
-        return false;
+    QuadTree *node = obj->qt;
 
-    objects.erase(index);
-    obj->qt = nullptr;
-    discardEmptyBuckets();
+    node->detach(obj);
+    node->discardEmptyBuckets();
     return true;
 }
 
-// Removes and re-inserts object into quadtree (for objects that move)
+// Moves object to the node its current bound belongs in (for objects that move)
 bool QuadTree::update(Collidable *obj) {
-    if (!remove(obj)) return false;
+    if (!contains(obj)) return false;
 
-    // Not contained in this node -- insert into parent
-    if (parent != nullptr && !bounds.contains(obj->bound))
-        return parent->insert(obj);
-    if (!isLeaf) {
-        // Still within current node -- insert into leaf
-        if (QuadTree *child = getChild(obj->bound))
-            return child->insert(obj);
+    QuadTree *node = obj->qt;
+
+    // Not contained in its node anymore -- climb until it is
+    QuadTree *target = node;
+    while (target->parent != nullptr && !target->loose.contains(obj->bound))
+        target = target->parent;
+    // Then descend as far as it fits
+    while (!target->isLeaf) {
+        QuadTree *child = target->getChild(obj->bound);
+        if (child == nullptr) break;
+        target = child;
+    }
+    // Still belongs where it is
+    if (target == node) {
+        node->stamp();
+        return true;
     }
-    return insert(obj);
+
+    node->detach(obj);
+    target->attach(obj);
+    node->discardEmptyBuckets();
+    return true;
 }
 
-// Check if object exists in quadtree
+// Check if object exists in quadtree. Several trees may be in use at once
+// (see PartitionedIndex), so the owning node must belong to this one
 bool QuadTree::contains(Collidable *obj) const noexcept {
-    if (obj->qt == nullptr) return false;
-    if (obj->qt != this) return obj->qt->contains(obj);
-    return std::find(objects.begin(), objects.end(), obj) != objects.end();
+    return obj->qt != nullptr && obj->qt->root == root && obj->qt->owns(obj);
 }
 
-// Searches quadtree for objects within the provided boundary and returns them in vector
-const std::vector<Collidable*> &QuadTree::getObjectsInBound(const Rect &bound) {
-    foundObjects.clear();
-    for (const auto &obj : objects) {
+bool QuadTree::touch(Collidable *obj) noexcept {
+    if (!contains(obj)) return false;
+    obj->qt->stamp();
+    return true;
+}
+
+// Walks quadtree for objects within the provided boundary
+bool QuadTree::visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    if (changed < since) return true; // Nothing changed below here
+    if (!mayContain(occupancy, types)) return true; // Nothing of the requested types below here
+
+    root->counters.examined += objects.size();
+    for (Collidable *obj : objects) {
         // Only check for intersection with OTHER boundaries
-        if (&obj->bound != &bound && obj->bound.intersects(bound))
-            foundObjects.push_back(obj);
+        if (&obj->bound == &bound || !matches(obj->flag, types) || !obj->bound.intersects(bound))
+            continue;
+        ++root->counters.returned;
+        if (!visit(obj, context))
+            return false;
     }
     if (!isLeaf) {
-        // Get objects from leaves
-        if (QuadTree *child = getChild(bound)) {
-            child->getObjectsInBound(bound);
-            foundObjects.insert(foundObjects.end(), child->foundObjects.begin(), child->foundObjects.end());
-        } else for (QuadTree *leaf : children) {
-            if (leaf->bounds.intersects(bound)) {
-                const std::vector<Collidable*> &leafFoundObjects = leaf->getObjectsInBound(bound);
-                foundObjects.insert(foundObjects.end(), leafFoundObjects.begin(), leafFoundObjects.end());
-            }
+        // Get objects from leaves. Loose children overlap, so one
+        // containing bound does not mean its siblings can be skipped
+        if (looseness == 1) {
+            if (QuadTree *child = getChild(bound))
+                return child->visitInBound(bound, types, since, visit, context);
+        }
+        for (QuadTree *leaf : children) {
+            if (leaf->loose.intersects(bound) && !leaf->visitInBound(bound, types, since, visit, context))
+                return false;
         }
     }
-    return foundObjects;
+    return true;
+}
+
+// Best-first search for the nearest objects. A node's loose bounds hold
+// everything below it, so its distance is a lower bound for its objects
+void QuadTree::getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+    unsigned char types, double maxDistance) const {
+    double limit = maxDistance * maxDistance;
+    std::priority_queue<NearestEntry<const QuadTree*>> queue;
+    queue.push({ 0, nullptr, this }); // Objects outside the map are kept in the root
+    while (k > 0 && !queue.empty()) {
+        NearestEntry<const QuadTree*> entry = queue.top();
+        queue.pop();
+        if (entry.distance > limit) break;
+        if (entry.obj != nullptr) {
+            out.push_back(entry.obj);
+            --k;
+            continue;
+        }
+        const QuadTree *node = entry.region;
+        if (!mayContain(node->occupancy, types)) continue;
+        for (Collidable *obj : node->objects) {
+            if (matches(obj->flag, types))
+                queue.push({ obj->bound.distanceSquared(x, y), obj, nullptr });
+        }
+        if (node->isLeaf) continue;
+        for (const QuadTree *child : node->children)
+            queue.push({ child->loose.distanceSquared(x, y), nullptr, child });
+    }
 }
 
 // Returns total children count for this quadtree
@@ -198,6 +173,7 @@ void QuadTree::clear() noexcept {
             obj->qt = nullptr;
         objects.clear();
     }
+    occupancy.clear();
     if (!isLeaf) {
         for (QuadTree *child : children) {
             child->clear();
@@ -207,6 +183,85 @@ void QuadTree::clear() noexcept {
     }
 }
 
+// Reinserts every object. Unlike ArenaQuadTree there is no bulk build,
+// as every node is its own allocation anyway
+void QuadTree::rebuild() {
+    std::vector<Collidable*> all;
+    all.reserve(totalObjects());
+    collect(all);
+    clear();
+    for (Collidable *obj : all)
+        insert(obj);
+}
+
+// Adds this node and all of its descendants to stats
+void QuadTree::collectStats(IndexStats &stats) const {
+    if (parent == nullptr)
+        stats.counters += counters;
+    ++stats.nodes;
+    if (stats.objectsAtDepth.size() <= level)
+        stats.objectsAtDepth.resize(level + 1);
+    stats.objectsAtDepth[level] += (unsigned)objects.size();
+    stats.maxNodeObjects = std::max(stats.maxNodeObjects, (unsigned)objects.size());
+    if (isLeaf) {
+        ++stats.leaves;
+        if (objects.empty()) ++stats.emptyLeaves;
+        return;
+    }
+    stats.straddlers += (unsigned)objects.size();
+    for (QuadTree *child : children)
+        child->collectStats(stats);
+}
+
+// Appends the objects of this node and all of its descendants to out
+void QuadTree::collect(std::vector<Collidable*> &out) const {
+    out.insert(out.end(), objects.begin(), objects.end());
+    if (isLeaf) return;
+    for (QuadTree *child : children)
+        child->collect(out);
+}
+
+// Stamps this node and its ancestors with the current epoch. Ancestors
+// are never stamped earlier than their descendants, so the walk can stop
+// at the first node that already has it
+void QuadTree::stamp() noexcept {
+    unsigned long long current = root->epoch;
+    for (QuadTree *node = this; node != nullptr && node->changed != current; node = node->parent)
+        node->changed = current;
+}
+
+// Appends object to this node, subdividing if required
+void QuadTree::attach(Collidable *obj) {
+    obj->qt = this;
+    obj->slot = (unsigned)objects.size();
+    objects.push_back(obj);
+    for (QuadTree *node = this; node != nullptr; node = node->parent)
+        node->occupancy.add(obj->flag);
+    stamp();
+
+    if (isLeaf && level < maxLevel && objects.size() >= capacity) {
+        subdivide();
+        update(obj);
+    }
+}
+
+// Swaps object with the last one in this node and pops it
+void QuadTree::detach(Collidable *obj) noexcept {
+    Collidable *last = objects.back();
+    objects[obj->slot] = last;
+    last->slot = obj->slot;
+    objects.pop_back();
+    obj->qt = nullptr;
+    for (QuadTree *node = this; node != nullptr; node = node->parent)
+        node->occupancy.remove(obj->flag);
+    stamp();
+}
+
+// Whether object is stored in this node
+bool QuadTree::owns(const Collidable *obj) const noexcept {
+    return obj->slot < objects.size() && objects[obj->slot] == obj;
+}
+
 // Subdivides into four quadrants
 void QuadTree::subdivide() {
     double hw = bounds.halfWidth();
@@ -221,11 +276,14 @@ void QuadTree::subdivide() {
             case 2: x = bounds.x() - qw; y = bounds.y() + qh; break; // Bottom left
             case 3: x = bounds.x() + qw; y = bounds.y() + qh; break; // Bottom right
         }
-        children[i] = new QuadTree({ x, y, hw, hh }, capacity, maxLevel);
+        children[i] = new QuadTree({ x, y, hw, hh }, capacity, maxLevel, looseness);
         children[i]->level = level + 1;
         children[i]->parent = this;
+        children[i]->root = root;
+        children[i]->changed = root->epoch;
     }
     isLeaf = false;
+    ++root->counters.subdivisions;
 }
 
 // Discards buckets if all children are leaves and contain no objects
@@ -235,6 +293,7 @@ void QuadTree::discardEmptyBuckets() {
         for (QuadTree *child : children)
             if (!child->isLeaf || !child->objects.empty())
                 return;
+        ++root->counters.collapses;
     }
     clear();
     if (parent != nullptr)
@@ -243,6 +302,14 @@ void QuadTree::discardEmptyBuckets() {
 
 // Returns child that contains the provided boundary
 QuadTree *QuadTree::getChild(const Rect &bound) const noexcept {
+    if (looseness > 1) {
+        // Quadrant holding the center, as long as bound fits its loose bounds
+        bool right = bound.x() > bounds.x();
+        QuadTree *child = bound.y() > bounds.y() ?
+            children[right ? 3 : 2] : // bottom right / bottom left
+            children[right ? 0 : 1];  // top right / top left
+        return child->loose.contains(bound) ? child : nullptr;
+    }
     bool right = bound.left() > bounds.x();
     bool left = !right && bound.right() < bounds.x();
 
@@ -1,96 +1,59 @@
 /***************************************
 QuadTree, but for a map with its origin
-at the center as opposed to the top left
+at the center as opposed to the top left.
+With a looseness above 1 every node also
+has a loose bound that many times its
+size, and objects go to the child that
+holds their center if they fit in it
 ***************************************/
 
 #pragma once
-#include <any>
-#include <vector>
+#include "SpatialIndex.hpp"
 
-class Rect {
+class QuadTree final : public SpatialIndex {
 public:
-    Rect(const Rect&) noexcept;
-    Rect(const std::initializer_list<double> &points);
-    Rect(double X = 0, double Y = 0, double Width = 0, double Height = 0) noexcept;
-
-    void setPosition(double X, double Y) noexcept;
-    void setSize(double Width, double Height) noexcept;
-    void update(double X, double Y, double Width, double Height) noexcept;
-
-    double x() const noexcept;
-    double y() const noexcept;
-    double width() const noexcept;
-    double height() const noexcept;
-    double halfWidth() const noexcept;
-    double halfHeight() const noexcept;
-    double left() const noexcept;
-    double top() const noexcept;
-    double right() const noexcept;
-    double bottom() const noexcept;
-
-    bool contains(const Rect &other) const noexcept;
-    bool intersects(const Rect &other) const noexcept;
-
-private:
-    double _x          = 0;
-    double _y          = 0;
-    double _width      = 0;
-    double _height     = 0;
-    double _halfWidth  = 0;
-    double _halfHeight = 0;
-    double _left       = 0;
-    double _top        = 0;
-    double _right      = 0;
-    double _bottom     = 0;
-
-    // Keeps left, top, right, bottom updated for Rect::contains()
-    // and QuadTree::getChild() methods. More efficient than 
-    // calculating each endpoint per call, especially for quadtrees
-    // with a large number of non-moving objects
-    void updateEndpoints() noexcept;
-};
-
-class QuadTree;
-struct Collidable {
-    friend class QuadTree;
-public:
-    Rect bound;
-    std::any data;
-
-    Collidable(const Rect &_bounds = {}, std::any _data = {});
-private:
-    QuadTree *qt = nullptr;
-    Collidable(const Collidable&) = delete;
-};
-
-class QuadTree {
-public:
-    QuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel);
+    QuadTree(const Rect &_bound, unsigned _capacity, unsigned _maxLevel, double _looseness = 1);
     QuadTree(const QuadTree&);
     QuadTree();
 
-    bool insert(Collidable *obj);
-    bool remove(Collidable *obj) noexcept;
-    bool update(Collidable *obj);
-    bool contains(Collidable *obj) const noexcept;
-    const std::vector<Collidable*> &getObjectsInBound(const Rect &bound);
-    unsigned totalChildren() const noexcept;
-    unsigned totalObjects() const noexcept;
-    const Rect &getBounds() const noexcept;
-    void clear() noexcept;
+    bool insert(Collidable *obj) override;
+    bool remove(Collidable *obj) noexcept override;
+    bool update(Collidable *obj) override;
+    bool contains(Collidable *obj) const noexcept override;
+    bool touch(Collidable *obj) noexcept override;
+    unsigned totalChildren() const noexcept override;
+    unsigned totalObjects() const noexcept override;
+    const Rect &getBounds() const noexcept override;
+    void clear() noexcept override;
+    void rebuild() override;
+    void collectStats(IndexStats &stats) const override;
+    void getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+        unsigned char types = anyType, double maxDistance = std::numeric_limits<double>::infinity()) const override;
 
     ~QuadTree();
 private:
     bool	  isLeaf      = true;
     Rect      bounds      = Rect();
+    Rect      loose       = Rect(); // bounds scaled by looseness -- what objects in this node must fit in
+    double    looseness   = 1;
     unsigned  level       = 0;
     unsigned  capacity    = 0;
     unsigned  maxLevel    = 0;
     QuadTree* parent      = nullptr;
+    QuadTree* root        = this;    // Holds the epoch for the whole tree
+    unsigned long long changed = 0;  // Epoch of the last change to this node or its descendants
     QuadTree* children[4] = { nullptr, nullptr, nullptr, nullptr };
-    std::vector<Collidable*> objects, foundObjects;
-
+    std::vector<Collidable*> objects;
+    TypeCounts occupancy; // Objects in this node and its descendants, by type
+
+    bool visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const override;
+    void stamp() noexcept;
+    void attach(Collidable *obj);
+    void detach(Collidable *obj) noexcept;
+    bool owns(const Collidable *obj) const noexcept;
     void subdivide();
+    void collect(std::vector<Collidable*> &out) const;
     void discardEmptyBuckets();
     inline QuadTree *getChild(const Rect &bound) const noexcept;
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+/***************************************
+Per-type slab storage with generational
+handles. Objects live in fixed-size
+chunks that never move, so pointers to
+them stay valid until they are destroyed.
+A handle records the generation of its
+slot, which is bumped whenever the slot
+is freed, so handles outliving their
+object stop resolving instead of
+pointing at whatever reused the slot
+***************************************/
+
+#pragma once
+#include <vector>
+#include <algorithm> // std::min, std::max
+#include <memory>    // std::unique_ptr
+#include <new>       // placement new
+#include <stdexcept> // std::length_error
+#include <utility>   // std::forward
+#include <cstdint>
+
+// 32-bit reference to a slab slot: [generation:9][type:3][index:20]
+struct Handle {
+    static constexpr unsigned INDEX_BITS      = 20;
+    static constexpr unsigned TYPE_BITS       = 3;
+    static constexpr unsigned GENERATION_BITS = 9;
+    static constexpr unsigned MAX_INDEX       = (1u << INDEX_BITS) - 1;
+    static constexpr unsigned MAX_GENERATION  = (1u << GENERATION_BITS) - 1;
+
+    uint32_t value = 0; // Generations start at 1, so 0 never refers to anything
+
+    Handle() noexcept = default;
+    Handle(unsigned index, unsigned type, unsigned generation) noexcept :
+        value(index | type << INDEX_BITS | generation << (INDEX_BITS + TYPE_BITS)) {
+    }
+
+    unsigned index() const noexcept { return value & MAX_INDEX; }
+    unsigned type() const noexcept { return (value >> INDEX_BITS) & ((1u << TYPE_BITS) - 1); }
+    unsigned generation() const noexcept { return value >> (INDEX_BITS + TYPE_BITS); }
+
+    explicit operator bool() const noexcept { return value != 0; }
+    bool operator==(const Handle &other) const noexcept { return value == other.value; }
+    bool operator!=(const Handle &other) const noexcept { return value != other.value; }
+};
+
+// Handle lookup shared by the slabs of every type derived from Base
+template <class Base>
+class SlabBase {
+public:
+    virtual ~SlabBase() = default;
+
+    // Object a handle refers to, or nullptr if it has been destroyed since
+    Base *get(Handle handle) const noexcept {
+        unsigned index = handle.index();
+        return index < slots.size() && generations[index] == handle.generation() ? slots[index] : nullptr;
+    }
+    // Destroys the object a handle refers to and frees its slot
+    virtual void destroy(Handle handle) noexcept = 0;
+    // Allocates room for count objects up front
+    virtual void reserve(unsigned count) = 0;
+
+    unsigned size() const noexcept { return live; }                      // Objects alive
+    unsigned capacity() const noexcept { return (unsigned)slots.size(); } // Slots ever used
+    unsigned highWater() const noexcept { return peak; }                 // Most objects alive at once
+
+protected:
+    std::vector<Base*>          slots;       // Object in each slot, nullptr while free
+    std::vector<unsigned short> generations; // Current generation of each slot
+    std::vector<unsigned>       freeSlots; // Most recently freed last, so reuse hits warm memory
+    unsigned                    live = 0;
+    unsigned                    peak = 0;
+};
+
+template <class T, class Base = T>
+class Slab final : public SlabBase<Base> {
+public:
+    explicit Slab(unsigned _type) noexcept :
+        type(_type) {
+    }
+
+    // Constructs an object in a free slot, returning it along with its handle
+    template <class... Args>
+    T *create(Handle &handle, Args&&... args) {
+        unsigned index;
+        if (!this->freeSlots.empty()) {
+            index = this->freeSlots.back();
+            this->freeSlots.pop_back();
+        } else {
+            index = (unsigned)this->slots.size();
+            if (index > Handle::MAX_INDEX)
+                throw std::length_error("Slab is full");
+            if (index / CHUNK_SIZE == chunks.size())
+                chunks.emplace_back(new Chunk);
+            this->slots.push_back(nullptr);
+            this->generations.push_back(1);
+        }
+        T *object = new (address(index)) T(std::forward<Args>(args)...);
+        this->slots[index] = object;
+        this->peak = std::max(this->peak, ++this->live);
+        handle = Handle(index, type, this->generations[index]);
+        return object;
+    }
+
+    void destroy(Handle handle) noexcept override {
+        if (this->get(handle) == nullptr) return; // Already destroyed
+        unsigned index = handle.index();
+        static_cast<T*>(this->slots[index])->~T();
+        this->slots[index] = nullptr;
+        this->generations[index] = (unsigned short)(this->generations[index] % Handle::MAX_GENERATION + 1);
+        this->freeSlots.push_back(index);
+        --this->live;
+    }
+
+    void reserve(unsigned count) override {
+        count = std::min(count, Handle::MAX_INDEX + 1);
+        while (chunks.size() * CHUNK_SIZE < count)
+            chunks.emplace_back(new Chunk);
+        this->slots.reserve(count);
+        this->generations.reserve(count);
+    }
+
+    ~Slab() {
+        for (unsigned index = 0; index < this->slots.size(); ++index) {
+            if (this->slots[index] != nullptr)
+                static_cast<T*>(this->slots[index])->~T();
+        }
+    }
+
+private:
+    static constexpr unsigned CHUNK_SIZE = 256; // Objects per chunk
+
+    struct Chunk {
+        alignas(T) unsigned char bytes[CHUNK_SIZE * sizeof(T)];
+    };
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    unsigned type = 0; // Recorded in every handle this slab hands out
+
+    void *address(unsigned index) noexcept {
+        return chunks[index / CHUNK_SIZE]->bytes + index % CHUNK_SIZE * sizeof(T);
+    }
+};
@@ -0,0 +1,245 @@
+#include "SpatialGrid.hpp"
+#include <algorithm> // SpatialGrid::SpatialGrid(), SpatialGrid::column(), SpatialGrid::row(), SpatialGrid::collectStats()
+#include <cmath>     // SpatialGrid::SpatialGrid(), SpatialGrid::column(), SpatialGrid::row()
+
+SpatialGrid::SpatialGrid(const Rect &_bound, double _cellSize) :
+    bounds(_bound),
+    cellSize(std::max(_cellSize, 1.0)) {
+    columns = std::max(1u, (unsigned)std::ceil(bounds.width() / cellSize));
+    rows = std::max(1u, (unsigned)std::ceil(bounds.height() / cellSize));
+    oversize = columns * rows;
+    cells.resize(oversize + 1);
+}
+
+// Inserts an object into the cell holding its center
+bool SpatialGrid::insert(Collidable *obj) {
+    if (obj->node != NONE) return false;
+    attach(getCell(obj->bound), obj);
+    return true;
+}
+
+// Removes an object from this grid
+bool SpatialGrid::remove(Collidable *obj) noexcept {
+    if (!contains(obj))
+        return false; // Cannot exist in vector
+
+    detach(obj);
+    return true;
+}
+
+// Moves object to the cell its current bound belongs in (for objects that move)
+bool SpatialGrid::update(Collidable *obj) {
+    if (!contains(obj)) return false;
+
+    unsigned target = getCell(obj->bound);
+    if (target == obj->node) {
+        cells[target].changed = epoch; // Still belongs where it is
+        return true;
+    }
+    detach(obj);
+    attach(target, obj);
+    return true;
+}
+
+// Check if object exists in grid
+bool SpatialGrid::contains(Collidable *obj) const noexcept {
+    if (obj->node >= cells.size()) return false;
+    const std::vector<Collidable*> &objects = cells[obj->node].objects;
+    return obj->slot < objects.size() && objects[obj->slot] == obj;
+}
+
+bool SpatialGrid::touch(Collidable *obj) noexcept {
+    if (!contains(obj)) return false;
+    cells[obj->node].changed = epoch;
+    return true;
+}
+
+// Walks every cell an object intersecting bound could be stored in
+bool SpatialGrid::visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    if (!visitCell(cells[oversize], bound, types, since, visit, context))
+        return false;
+
+    // Objects reach at most half a cell past the cell holding their center
+    double reach = cellSize * 0.5;
+    unsigned firstColumn = column(bound.left() - reach), lastColumn = column(bound.right() + reach);
+    unsigned firstRow = row(bound.bottom() - reach), lastRow = row(bound.top() + reach);
+    for (unsigned r = firstRow; r <= lastRow; ++r) {
+        for (unsigned c = firstColumn; c <= lastColumn; ++c) {
+            if (!visitCell(cells[r * columns + c], bound, types, since, visit, context))
+                return false;
+        }
+    }
+    return true;
+}
+bool SpatialGrid::visitCell(const Cell &cell, const Rect &bound, unsigned char types, unsigned long long since,
+    Visitor visit, void *context) const {
+    if (cell.changed < since || !mayContain(cell.occupancy, types)) return true;
+
+    counters.examined += cell.objects.size();
+    for (Collidable *obj : cell.objects) {
+        // Only check for intersection with OTHER boundaries
+        if (&obj->bound == &bound || !matches(obj->flag, types) || !obj->bound.intersects(bound))
+            continue;
+        ++counters.returned;
+        if (!visit(obj, context))
+            return false;
+    }
+    return true;
+}
+
+// Searches rings of cells outwards from the one holding the point. Objects
+// reach at most half a cell past their own, so nothing in ring i or beyond
+// is nearer than i - 1.5 cells and queued objects within that are final
+void SpatialGrid::getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+    unsigned char types, double maxDistance) const {
+    double limit = maxDistance * maxDistance;
+    std::priority_queue<NearestEntry<unsigned>> queue;
+    queueCell(cells[oversize], x, y, types, limit, queue);
+
+    int centerColumn = (int)column(x), centerRow = (int)row(y);
+    unsigned rings = std::max(columns, rows);
+    for (unsigned ring = 0; ; ++ring) {
+        double reach = ring < rings ? std::max(0.0, (ring - 1.5) * cellSize) : std::numeric_limits<double>::infinity();
+        while (k > 0 && !queue.empty() && queue.top().distance <= reach * reach) {
+            out.push_back(queue.top().obj);
+            queue.pop();
+            --k;
+        }
+        if (k == 0 || ring == rings || reach * reach > limit) return;
+
+        int firstRow = centerRow - (int)ring, lastRow = centerRow + (int)ring;
+        int firstColumn = centerColumn - (int)ring, lastColumn = centerColumn + (int)ring;
+        for (int r = std::max(firstRow, 0); r <= std::min(lastRow, (int)rows - 1); ++r) {
+            if (r == firstRow || r == lastRow) {
+                for (int c = std::max(firstColumn, 0); c <= std::min(lastColumn, (int)columns - 1); ++c)
+                    queueCell(cells[r * columns + c], x, y, types, limit, queue);
+                continue;
+            }
+            // Only the two ends of rows in between belong to the ring
+            if (firstColumn >= 0)
+                queueCell(cells[r * columns + firstColumn], x, y, types, limit, queue);
+            if (lastColumn < (int)columns)
+                queueCell(cells[r * columns + lastColumn], x, y, types, limit, queue);
+        }
+    }
+}
+void SpatialGrid::queueCell(const Cell &cell, double x, double y, unsigned char types, double limit,
+    std::priority_queue<NearestEntry<unsigned>> &queue) const {
+    if (!mayContain(cell.occupancy, types)) return;
+
+    for (Collidable *obj : cell.objects) {
+        if (!matches(obj->flag, types)) continue;
+        double distance = obj->bound.distanceSquared(x, y);
+        if (distance <= limit)
+            queue.push({ distance, obj, 0 });
+    }
+}
+
+// Returns total cell count for this grid
+unsigned SpatialGrid::totalChildren() const noexcept {
+    return oversize;
+}
+
+// Returns total object count for this grid
+unsigned SpatialGrid::totalObjects() const noexcept {
+    return count;
+}
+
+// Every cell counts as a node and a leaf, all of them at depth 0.
+// Objects too large for a cell are reported as straddlers
+void SpatialGrid::collectStats(IndexStats &stats) const {
+    stats.nodes  += (unsigned)cells.size();
+    stats.leaves += (unsigned)cells.size();
+    for (const Cell &cell : cells) {
+        if (cell.objects.empty()) ++stats.emptyLeaves;
+        stats.maxNodeObjects = std::max(stats.maxNodeObjects, (unsigned)cell.objects.size());
+    }
+    stats.straddlers += (unsigned)cells[oversize].objects.size();
+    if (stats.objectsAtDepth.empty())
+        stats.objectsAtDepth.resize(1);
+    stats.objectsAtDepth[0] += count;
+    stats.counters += counters;
+}
+
+const Rect &SpatialGrid::getBounds() const noexcept {
+    return bounds;
+}
+
+// Removes all objects from this grid
+void SpatialGrid::clear() noexcept {
+    for (Cell &cell : cells) {
+        for (Collidable *obj : cell.objects)
+            obj->node = NONE;
+        cell.objects.clear();
+        cell.occupancy.clear();
+        cell.changed = epoch;
+    }
+    count = 0;
+}
+
+// Moves every object whose center has changed cells in a single pass.
+// Objects moved forward are looked at again when their new cell is reached.
+// Any object may have moved, so every cell holding one is stamped
+void SpatialGrid::rebuild() {
+    for (unsigned index = 0; index < cells.size(); ++index) {
+        std::vector<Collidable*> &objects = cells[index].objects;
+        if (!objects.empty())
+            cells[index].changed = epoch;
+        for (unsigned slot = 0; slot < objects.size();) {
+            Collidable *obj = objects[slot];
+            unsigned target = getCell(obj->bound);
+            if (target == index) {
+                ++slot;
+                continue;
+            }
+            detach(obj); // Moves the last object of the cell into slot
+            attach(target, obj);
+        }
+    }
+}
+
+// Appends object to a cell
+void SpatialGrid::attach(unsigned index, Collidable *obj) {
+    obj->node = index;
+    obj->slot = (unsigned)cells[index].objects.size();
+    cells[index].objects.push_back(obj);
+    cells[index].occupancy.add(obj->flag);
+    cells[index].changed = epoch;
+    ++count;
+}
+
+// Swaps object with the last one in its cell and pops it
+void SpatialGrid::detach(Collidable *obj) noexcept {
+    std::vector<Collidable*> &objects = cells[obj->node].objects;
+    cells[obj->node].occupancy.remove(obj->flag);
+    cells[obj->node].changed = epoch;
+    Collidable *last = objects.back();
+    objects[obj->slot] = last;
+    last->slot = obj->slot;
+    objects.pop_back();
+    obj->node = NONE;
+    --count;
+}
+
+// Returns cell holding the center of bound, or the oversize list if bound is larger than a cell.
+// Objects outside the grid are kept in the nearest edge cell
+unsigned SpatialGrid::getCell(const Rect &bound) const noexcept {
+    if (bound.width() > cellSize || bound.height() > cellSize)
+        return oversize;
+    return row(bound.y()) * columns + column(bound.x());
+}
+
+unsigned SpatialGrid::column(double x) const noexcept {
+    double c = std::floor((x - bounds.left()) / cellSize);
+    return (unsigned)std::clamp(c, 0.0, (double)(columns - 1));
+}
+
+unsigned SpatialGrid::row(double y) const noexcept {
+    double r = std::floor((y - bounds.bottom()) / cellSize);
+    return (unsigned)std::clamp(r, 0.0, (double)(rows - 1));
+}
+
+SpatialGrid::~SpatialGrid() {
+    clear();
+}
@@ -0,0 +1,61 @@
+/***************************************
+Uniform grid of square cells. An object
+is stored in the cell holding its center
+so long as it is no larger than a cell,
+which bounds how far it can reach into
+neighbouring cells. Anything larger goes
+in a separate list every query checks
+***************************************/
+
+#pragma once
+#include "SpatialIndex.hpp"
+#include <queue>
+
+class SpatialGrid final : public SpatialIndex {
+public:
+    SpatialGrid(const Rect &_bound, double _cellSize);
+
+    bool insert(Collidable *obj) override;
+    bool remove(Collidable *obj) noexcept override;
+    bool update(Collidable *obj) override;
+    bool contains(Collidable *obj) const noexcept override;
+    bool touch(Collidable *obj) noexcept override;
+    unsigned totalChildren() const noexcept override;
+    unsigned totalObjects() const noexcept override;
+    const Rect &getBounds() const noexcept override;
+    void clear() noexcept override;
+    void rebuild() override;
+    void collectStats(IndexStats &stats) const override;
+    void getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+        unsigned char types = anyType, double maxDistance = std::numeric_limits<double>::infinity()) const override;
+
+    ~SpatialGrid();
+private:
+    static constexpr unsigned NONE = Collidable::NONE;
+
+    Rect     bounds;
+    double   cellSize = 0;
+    unsigned columns  = 0;
+    unsigned rows     = 0;
+    unsigned oversize = 0; // Index of the list holding objects larger than a cell (after the last cell)
+    unsigned count    = 0;
+
+    struct Cell {
+        std::vector<Collidable*> objects;
+        TypeCounts occupancy;
+        unsigned long long changed = 0; // Epoch of the last change to objects
+    };
+    std::vector<Cell> cells;
+
+    bool visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const override;
+    bool visitCell(const Cell &cell, const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const;
+    void queueCell(const Cell &cell, double x, double y, unsigned char types, double limit,
+        std::priority_queue<NearestEntry<unsigned>> &queue) const;
+    void attach(unsigned index, Collidable *obj);
+    void detach(Collidable *obj) noexcept;
+    unsigned getCell(const Rect &bound) const noexcept;
+    inline unsigned column(double x) const noexcept;
+    inline unsigned row(double y) const noexcept;
+};
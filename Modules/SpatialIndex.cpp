@@ -0,0 +1,114 @@
+#include "SpatialIndex.hpp"
+#include <assert.h> // Rect::Rect()
+
+//** Rect **//
+Rect::Rect(const Rect &other) noexcept :
+    _left(other._left),
+    _bottom(other._bottom),
+    _right(other._right),
+    _top(other._top) {
+}
+Rect::Rect(const std::initializer_list<double> &points) {
+    assert(points.size() != 3); // Initializer list may only contain 4 doubles.
+    update(*points.begin(), *(points.begin()+1), *(points.begin()+2), *(points.begin()+3));
+}
+Rect::Rect(double X, double Y, double Width, double Height) noexcept {
+    update(X, Y, Width, Height);
+}
+
+void Rect::setPosition(double X, double Y) noexcept {
+    update(X, Y, width(), height());
+}
+void Rect::setSize(double Width, double Height) noexcept {
+    update(x(), y(), Width, Height);
+}
+void Rect::update(double X, double Y, double Width, double Height) noexcept {
+    double halfWidth = Width * 0.5;
+    double halfHeight = Height * 0.5;
+    _left   = (float)(X - halfWidth);
+    _bottom = (float)(Y - halfHeight);
+    _right  = (float)(X + halfWidth);
+    _top    = (float)(Y + halfHeight);
+}
+
+double Rect::x() const noexcept { return ((double)_left + _right) * 0.5; }
+double Rect::y() const noexcept { return ((double)_bottom + _top) * 0.5; }
+double Rect::width() const noexcept { return (double)_right - _left; }
+double Rect::height() const noexcept { return (double)_top - _bottom; }
+double Rect::halfWidth() const noexcept { return width() * 0.5; }
+double Rect::halfHeight() const noexcept { return height() * 0.5; }
+double Rect::left() const noexcept { return _left; }
+double Rect::top() const noexcept { return _top; }
+double Rect::right() const noexcept { return _right; }
+double Rect::bottom() const noexcept { return _bottom; }
+
+// For map in which X increases from left to right and Y increases from bottom to top
+bool Rect::contains(const Rect &other) const noexcept {
+    if (other._left   < _left)   return false;
+    if (other._top    > _top)    return false;
+    if (other._right  > _right)  return false;
+    if (other._bottom < _bottom) return false;
+    return true; // inside bounds
+}
+bool Rect::intersects(const Rect &other) const noexcept {
+    if (_left > other._right || _right < other._left) return false;
+    if (_bottom > other._top || _top < other._bottom) return false;
+    return true; // intersection
+}
+double Rect::distanceSquared(double X, double Y) const noexcept {
+    double dx = X < _left ? _left - X : X > _right ? X - _right : 0;
+    double dy = Y < _bottom ? _bottom - Y : Y > _top ? Y - _top : 0;
+    return dx * dx + dy * dy;
+}
+bool Rect::operator==(const Rect &other) const noexcept {
+    return _left == other._left && _bottom == other._bottom && _right == other._right && _top == other._top;
+}
+
+//** Collidable **//
+Collidable::Collidable(const Rect &_bounds, Entity *_entity, unsigned char _flag) :
+    bound(_bounds),
+    entity(_entity),
+    flag(_flag) {
+}
+
+//** TypeCounts **//
+void TypeCounts::add(unsigned char flag) noexcept {
+    for (unsigned bit = 0; bit < 8; ++bit) {
+        if (flag & (1 << bit) && count[bit]++ == 0)
+            mask |= (unsigned char)(1 << bit);
+    }
+}
+void TypeCounts::add(const TypeCounts &other) noexcept {
+    for (unsigned bit = 0; bit < 8; ++bit)
+        count[bit] += other.count[bit];
+    mask |= other.mask;
+}
+void TypeCounts::remove(unsigned char flag) noexcept {
+    for (unsigned bit = 0; bit < 8; ++bit) {
+        if (flag & (1 << bit) && --count[bit] == 0)
+            mask &= (unsigned char)~(1 << bit);
+    }
+}
+void TypeCounts::clear() noexcept {
+    *this = TypeCounts();
+}
+
+//** SpatialIndex **//
+void SpatialIndex::setEpoch(unsigned long long _epoch) noexcept {
+    epoch = _epoch;
+}
+void SpatialIndex::getObjectsInBound(const Rect &bound, std::vector<Collidable*> &out, unsigned char types) const {
+    forEachInBound(bound, types, [&out](Collidable *obj) {
+        out.push_back(obj);
+    });
+}
+void SpatialIndex::getObjectsInRadius(double x, double y, double radius, std::vector<Collidable*> &out, unsigned char types) const {
+    forEachInRadius(x, y, radius, types, [&out](Collidable *obj) {
+        out.push_back(obj);
+    });
+}
+const std::vector<Collidable*> &SpatialIndex::getObjectsInBound(const Rect &bound) {
+    foundObjects.clear();
+    getObjectsInBound(bound, foundObjects);
+    return foundObjects;
+}
\ No newline at end of file
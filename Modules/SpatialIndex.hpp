@@ -0,0 +1,244 @@
+/***************************************
+Common types for the spatial indexes the
+map can store its entities in. The map
+has its origin at the center, with Y
+increasing from bottom to top
+***************************************/
+
+#pragma once
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+// Axis-aligned box stored as its four float32 edges (16 bytes). Small
+// enough to keep one per entity and to mirror into the structure-of-
+// arrays leaf storage that ArenaQuadTree scans with SIMD
+class Rect {
+public:
+    Rect(const Rect&) noexcept;
+    Rect(const std::initializer_list<double> &points);
+    Rect(double X = 0, double Y = 0, double Width = 0, double Height = 0) noexcept;
+
+    void setPosition(double X, double Y) noexcept;
+    void setSize(double Width, double Height) noexcept;
+    void update(double X, double Y, double Width, double Height) noexcept;
+
+    double x() const noexcept;
+    double y() const noexcept;
+    double width() const noexcept;
+    double height() const noexcept;
+    double halfWidth() const noexcept;
+    double halfHeight() const noexcept;
+    double left() const noexcept;
+    double top() const noexcept;
+    double right() const noexcept;
+    double bottom() const noexcept;
+
+    bool contains(const Rect &other) const noexcept;
+    bool intersects(const Rect &other) const noexcept;
+    double distanceSquared(double X, double Y) const noexcept; // 0 if the point is inside
+    bool operator==(const Rect &other) const noexcept;
+
+private:
+    float _left   = 0;
+    float _bottom = 0;
+    float _right  = 0;
+    float _top    = 0;
+};
+
+class Entity;
+class QuadTree;
+class ArenaQuadTree;
+class SpatialGrid;
+struct Collidable {
+    friend class QuadTree;
+    friend class ArenaQuadTree;
+    friend class SpatialGrid;
+public:
+    Rect          bound;
+    Entity       *entity = nullptr; // Entity this object belongs to (not owned)
+    unsigned char flag   = 0;       // CellTypeFlags of the entity
+
+    Collidable(const Rect &_bounds = {}, Entity *_entity = nullptr, unsigned char _flag = 0);
+private:
+    static constexpr unsigned NONE = std::numeric_limits<unsigned>::max();
+
+    QuadTree *qt   = nullptr; // Owning node (QuadTree)
+    unsigned  node = NONE;    // Owning node index (ArenaQuadTree) or cell index (SpatialGrid)
+    unsigned  slot = NONE;    // Position in the owning node's objects, for O(1) removal
+    Collidable(const Collidable&) = delete;
+};
+
+// Object count per CellTypeFlags bit for a node, cell or subtree, so
+// that queries can skip regions holding none of the types they want
+struct TypeCounts {
+    unsigned      count[8] = {};
+    unsigned char mask     = 0; // Bits whose count is non-zero
+
+    void add(unsigned char flag) noexcept;
+    void add(const TypeCounts &other) noexcept;
+    void remove(unsigned char flag) noexcept;
+    void clear() noexcept;
+};
+
+// Object or region (node, cell) waiting in the best-first search of
+// getNearestObjects. std::priority_queue puts the nearest on top
+template <typename Region>
+struct NearestEntry {
+    double      distance; // Squared distance to the query point
+    Collidable *obj;      // nullptr if this entry is a region
+    Region      region;
+
+    bool operator<(const NearestEntry &other) const noexcept { return distance > other.distance; }
+};
+
+// Running totals an index keeps from its creation on
+struct IndexCounters {
+    unsigned long long subdivisions = 0; // Incremental only -- rebuild() is not counted
+    unsigned long long collapses    = 0;
+    unsigned long long queries      = 0; // Bound queries (forEachInBound and what is built on it)
+    unsigned long long examined     = 0; // Objects tested against a query's bound
+    unsigned long long returned     = 0; // Objects that passed and were visited
+
+    IndexCounters &operator+=(const IndexCounters &other) noexcept {
+        subdivisions += other.subdivisions;
+        collapses    += other.collapses;
+        queries      += other.queries;
+        examined     += other.examined;
+        returned     += other.returned;
+        return *this;
+    }
+};
+
+// Shape of a spatial index, for diagnostics and benchmarks
+struct IndexStats {
+    unsigned nodes          = 0; // Nodes (or grid cells) in use, roots included
+    unsigned leaves         = 0;
+    unsigned emptyLeaves    = 0;
+    unsigned maxNodeObjects = 0; // Most objects stored in a single node
+    unsigned straddlers     = 0; // Objects stuck in nodes with children (grid: too large for a cell)
+    std::vector<unsigned> objectsAtDepth; // Objects stored at each depth, 0 being the root. Grids only have depth 0
+    IndexCounters counters;
+};
+
+// Interface the map accesses its spatial index through
+class SpatialIndex {
+public:
+    // Return false to stop the query early
+    using Visitor = bool(*)(Collidable *obj, void *context);
+
+    // Type mask that disables filtering (also matches objects without a flag)
+    static constexpr unsigned char anyType = 0xFF;
+    static bool matches(unsigned char flag, unsigned char types) noexcept {
+        return types == anyType || (flag & types) != 0;
+    }
+    static bool mayContain(const TypeCounts &counts, unsigned char types) noexcept {
+        return types == anyType || (counts.mask & types) != 0;
+    }
+
+    virtual bool insert(Collidable *obj) = 0;
+    virtual bool remove(Collidable *obj) noexcept = 0;
+    virtual bool update(Collidable *obj) = 0;
+    virtual bool contains(Collidable *obj) const noexcept = 0;
+    // Stamps the node (or cell) holding obj with the current epoch, for an
+    // object that changed without moving. False if obj is not in the index
+    virtual bool touch(Collidable *obj) noexcept = 0;
+    virtual unsigned totalChildren() const noexcept = 0;
+    virtual unsigned totalObjects() const noexcept = 0;
+    virtual const Rect &getBounds() const noexcept = 0;
+    virtual void clear() noexcept = 0;
+
+    // Re-places every object from its current bound in one pass, for
+    // when objects were moved without calling update() on each of them
+    virtual void rebuild() = 0;
+
+    // Sets the epoch (game tick) stamped onto every node an object is
+    // inserted into, removed from or updated in, and onto its ancestors.
+    // Epochs must not decrease. rebuild() stamps every node it touches
+    virtual void setEpoch(unsigned long long _epoch) noexcept;
+
+    // Adds the shape and counters of this index to stats
+    virtual void collectStats(IndexStats &stats) const = 0;
+
+    // Calls visit(obj) for every object within bound without copying
+    // anything. visit must not modify the index while it runs. With a
+    // types mask, only objects whose flag is in it are visited
+    template <typename F>
+    bool forEachInBound(const Rect &bound, F &&visit) const;
+    template <typename F>
+    bool forEachInBound(const Rect &bound, unsigned char types, F &&visit) const;
+
+    // Same as forEachInBound, but skips every node (or cell) stamped before
+    // since. Visits a superset of the objects that changed from then on
+    template <typename F>
+    bool forEachChangedInBound(const Rect &bound, unsigned long long since, unsigned char types, F &&visit) const;
+
+    // Appends every object within bound (and of one of types) to out
+    void getObjectsInBound(const Rect &bound, std::vector<Collidable*> &out, unsigned char types = anyType) const;
+
+    // Same as above for objects whose bound is within radius of (x, y)
+    template <typename F>
+    bool forEachInRadius(double x, double y, double radius, unsigned char types, F &&visit) const;
+    void getObjectsInRadius(double x, double y, double radius, std::vector<Collidable*> &out, unsigned char types = anyType) const;
+
+    // Appends the k objects of one of types nearest to (x, y) and no further
+    // than maxDistance to out, nearest first. Nodes are visited best-first,
+    // so only the part of the index around the point is touched
+    virtual void getNearestObjects(double x, double y, unsigned k, std::vector<Collidable*> &out,
+        unsigned char types = anyType, double maxDistance = std::numeric_limits<double>::infinity()) const = 0;
+
+    // Results are overwritten by the next call -- prefer the overloads above
+    const std::vector<Collidable*> &getObjectsInBound(const Rect &bound);
+
+    virtual ~SpatialIndex() = default;
+
+protected:
+    unsigned long long epoch = 0;
+    mutable IndexCounters counters;
+
+    // Walks every object of one of types intersecting bound (other than the
+    // one owning bound itself) in nodes stamped at or after since. Returns
+    // false if visit stopped the walk
+    virtual bool visitInBound(const Rect &bound, unsigned char types, unsigned long long since,
+        Visitor visit, void *context) const = 0;
+
+private:
+    std::vector<Collidable*> foundObjects;
+};
+
+template <typename F>
+bool SpatialIndex::forEachInBound(const Rect &bound, F &&visit) const {
+    return forEachInBound(bound, anyType, std::forward<F>(visit));
+}
+template <typename F>
+bool SpatialIndex::forEachInBound(const Rect &bound, unsigned char types, F &&visit) const {
+    return forEachChangedInBound(bound, 0, types, std::forward<F>(visit));
+}
+template <typename F>
+bool SpatialIndex::forEachChangedInBound(const Rect &bound, unsigned long long since, unsigned char types, F &&visit) const {
+    ++counters.queries;
+    return visitInBound(bound, types, since, [](Collidable *obj, void *context) -> bool {
+        F &f = *static_cast<std::remove_reference_t<F>*>(context);
+        if constexpr (std::is_void_v<decltype(f(obj))>) {
+            f(obj);
+            return true;
+        } else {
+            return f(obj);
+        }
+    }, const_cast<void*>(static_cast<const void*>(&visit)));
+}
+template <typename F>
+bool SpatialIndex::forEachInRadius(double x, double y, double radius, unsigned char types, F &&visit) const {
+    double radiusSquared = radius * radius;
+    return forEachInBound({ x, y, radius * 2, radius * 2 }, types, [&](Collidable *obj) -> bool {
+        if (obj->bound.distanceSquared(x, y) > radiusSquared)
+            return true; // In the corners of the square, outside the circle
+        if constexpr (std::is_void_v<decltype(visit(obj))>) {
+            visit(obj);
+            return true;
+        } else {
+            return visit(obj);
+        }
+    });
+}
\ No newline at end of file
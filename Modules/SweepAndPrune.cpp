@@ -0,0 +1,142 @@
+#include "SweepAndPrune.hpp"
+#include "WorkerPool.hpp"
+#include <algorithm> // std::sort, std::merge, std::min
+#include <utility>   // std::swap
+
+void SweepAndPrune::clear() noexcept {
+    left.clear();
+    bottom.clear();
+    right.clear();
+    top.clear();
+    flags.clear();
+    types.clear();
+    orders.clear();
+    pairs.clear();
+    active = 0;
+}
+
+unsigned SweepAndPrune::add(float _left, float _bottom, float _right, float _top,
+    unsigned char flag, unsigned char _types, unsigned order) {
+    left.push_back(_left);
+    bottom.push_back(_bottom);
+    right.push_back(_right);
+    top.push_back(_top);
+    flags.push_back(flag);
+    types.push_back(_types);
+    orders.push_back(order);
+    if (order != PASSIVE) ++active;
+    return size() - 1;
+}
+
+// Merges neighbouring sorted runs of items, all pairs of runs at once on
+// the pool, until a single run is left. runs holds where each run starts,
+// then where the last one ends
+template <class T, class Less>
+static void mergeRuns(std::vector<T> &items, std::vector<T> &scratch, std::vector<size_t> &runs,
+    WorkerPool &pool, Less less) {
+    scratch.resize(items.size());
+    while (runs.size() > 2) {
+        const size_t last = runs.size() - 1;
+        pool.run((unsigned)(last + 1) / 2, [&](unsigned merge) {
+            // An odd run out is merged with nothing, which copies it
+            size_t begin = runs[2 * merge];
+            size_t middle = runs[std::min<size_t>(2 * merge + 1, last)];
+            size_t end = runs[std::min<size_t>(2 * merge + 2, last)];
+            std::merge(items.begin() + begin, items.begin() + middle, items.begin() + middle,
+                items.begin() + end, scratch.begin() + begin, less);
+        });
+        std::swap(items, scratch);
+        size_t kept = 0;
+        for (size_t run = 0; run < last; run += 2)
+            runs[kept++] = runs[run];
+        runs[kept++] = runs[last];
+        runs.resize(kept);
+    }
+}
+
+const std::vector<SweepAndPrune::Pair> &SweepAndPrune::sweep(WorkerPool *pool) {
+    const unsigned count = size();
+    sorted.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        sorted[i] = i;
+    auto byLeft = [this](unsigned a, unsigned b) {
+        return left[a] < left[b];
+    };
+    // Collisions are resolved in order, so keep it independent of the sort
+    // and of how the sweep was split up. first is always active, so no two
+    // pairs share an order and a second: this order is total
+    auto byOrder = [this](const Pair &a, const Pair &b) {
+        return orders[a.first] != orders[b.first] ? orders[a.first] < orders[b.first] : a.second < b.second;
+    };
+
+    pairs.clear();
+    if (pool == nullptr || pool->size() == 1 || count < 2) {
+        std::sort(sorted.begin(), sorted.end(), byLeft);
+        sweepStrip(0, count, pairs);
+        std::sort(pairs.begin(), pairs.end(), byOrder);
+        return pairs;
+    }
+    // Several chunks (and strips) per thread, as boxes are not spread evenly
+    const unsigned parts = std::min(count, pool->size() * 4);
+    auto partBegin = [count, parts](unsigned part) {
+        return (unsigned)((unsigned long long)count * part / parts);
+    };
+
+    // Each thread sorts chunks of the boxes, which are then merged. Ties
+    // may come out in another order than from one sort, but the pairs
+    // found and their order do not depend on it
+    runs.resize(parts + 1);
+    for (unsigned part = 0; part <= parts; ++part)
+        runs[part] = partBegin(part);
+    pool->run(parts, [&](unsigned part) {
+        std::sort(sorted.begin() + partBegin(part), sorted.begin() + partBegin(part + 1), byLeft);
+    });
+    mergeRuns(sorted, sortScratch, runs, *pool, byLeft);
+
+    // Then sweeps strips of them, sorting the pairs of each, which are merged too
+    stripPairs.resize(parts);
+    pool->run(parts, [&](unsigned strip) {
+        stripPairs[strip].clear();
+        sweepStrip(partBegin(strip), partBegin(strip + 1), stripPairs[strip]);
+        std::sort(stripPairs[strip].begin(), stripPairs[strip].end(), byOrder);
+    });
+    runs.clear();
+    for (unsigned strip = 0; strip < parts; ++strip) {
+        runs.push_back(pairs.size());
+        pairs.insert(pairs.end(), stripPairs[strip].begin(), stripPairs[strip].end());
+    }
+    runs.push_back(pairs.size());
+    mergeRuns(pairs, pairScratch, runs, *pool, byOrder);
+    return pairs;
+}
+
+// Each box meets the boxes starting before it ends along x, then
+// they are checked along y. Boxes are only read, so strips can be
+// swept at the same time
+void SweepAndPrune::sweepStrip(unsigned begin, unsigned end, std::vector<Pair> &out) const {
+    const unsigned count = size();
+    for (unsigned a = begin; a < end; ++a) {
+        const unsigned i = sorted[a];
+        const float iRight = right[i], iBottom = bottom[i], iTop = top[i];
+        for (unsigned b = a + 1; b < count; ++b) {
+            const unsigned j = sorted[b];
+            if (left[j] > iRight) break;
+            if (bottom[j] > iTop || top[j] < iBottom) continue;
+            unsigned first = i, second = j;
+            if (orders[j] < orders[i]) std::swap(first, second);
+            bool forward  = orders[first] != PASSIVE && (types[first] & flags[second]);
+            bool backward = orders[second] != PASSIVE && (types[second] & flags[first]);
+            if (!forward && !backward) continue;
+            if (!forward) std::swap(first, second); // Only the later one collides
+            out.push_back({ first, second, forward && backward });
+        }
+    }
+}
+
+unsigned SweepAndPrune::size() const noexcept {
+    return (unsigned)left.size();
+}
+
+unsigned SweepAndPrune::activeCount() const noexcept {
+    return active;
+}
@@ -0,0 +1,60 @@
+/***************************************
+Broad phase collision detection. Boxes
+are added once per tick, sorted along x
+and swept, so every overlapping pair is
+found once rather than by a spatial query
+from each of its two boxes. Only active
+boxes (ones that collide with others)
+start pairs; passive boxes are just hit
+***************************************/
+
+#pragma once
+#include <vector>
+#include <limits>
+#include <cstddef> // size_t
+
+class WorkerPool;
+
+class SweepAndPrune {
+public:
+    static constexpr unsigned PASSIVE = std::numeric_limits<unsigned>::max();
+
+    // first collides with second, and second with first as well if
+    // mutual. If both collide, first is the one with the lower order
+    struct Pair {
+        unsigned first, second;
+        bool     mutual;
+    };
+
+    // Forgets the boxes (and pairs) of the previous sweep
+    void clear() noexcept;
+
+    // Adds a box and returns its index. order ranks active boxes, which
+    // pair up with those whose flag is in their types; PASSIVE boxes only
+    // pair up with active ones
+    unsigned add(float left, float bottom, float right, float top,
+        unsigned char flag, unsigned char types, unsigned order);
+
+    // Finds every overlapping pair of boxes, sorted by the order of first.
+    // With a pool, the boxes are sorted, strips of them along x swept and
+    // the pairs sorted in parallel; the pairs come out the same as without one
+    const std::vector<Pair> &sweep(WorkerPool *pool = nullptr);
+
+    unsigned size() const noexcept;
+    unsigned activeCount() const noexcept;
+
+private:
+    std::vector<float>         left, bottom, right, top;
+    std::vector<unsigned char> flags, types;
+    std::vector<unsigned>      orders;
+    std::vector<unsigned>      sorted; // Box indices by left edge
+    std::vector<Pair>          pairs;
+    std::vector<std::vector<Pair>> stripPairs; // Pairs found in each strip by a pool
+    std::vector<unsigned>      sortScratch;    // Merge buffers for a pool
+    std::vector<Pair>          pairScratch;
+    std::vector<size_t>        runs;           // Sorted runs being merged
+    unsigned                   active = 0;
+
+    // Finds the pairs of the boxes at sorted positions [begin, end)
+    void sweepStrip(unsigned begin, unsigned end, std::vector<Pair> &out) const;
+};
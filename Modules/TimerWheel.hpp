@@ -0,0 +1,97 @@
+/***************************************
+Hierarchical timer wheel counting in
+ticks. Each level has 64 slots, each
+slot of a level spanning a whole turn of
+the level below it. Timers far off wait
+in a coarse slot and drop a level each
+time the wheel below comes around, so
+scheduling and firing are O(1) per level
+however many timers are pending
+***************************************/
+
+#pragma once
+#include <vector>
+#include <algorithm> // std::max, std::min
+#include <utility>   // std::swap
+
+template <class Payload>
+class TimerWheel {
+public:
+    static constexpr unsigned           SLOT_BITS = 6;
+    static constexpr unsigned           SLOTS     = 1u << SLOT_BITS;
+    static constexpr unsigned           LEVELS    = 4;
+    static constexpr unsigned long long MAX_DELAY = (1ull << (SLOT_BITS * LEVELS)) - 1; // Longer delays are cut to this
+
+    explicit TimerWheel(unsigned long long firstTick = 1) noexcept :
+        current(firstTick) {
+    }
+
+    // Fires payload delay ticks after the last tick advanced (the next one if delay is 0)
+    void schedule(unsigned long long delay, const Payload &payload) {
+        delay = std::min(std::max(delay, 1ull), MAX_DELAY);
+        place({ current - 1 + delay, payload });
+        ++pending;
+    }
+
+    // Advances one tick, calling fire(payload) for every timer due on it.
+    // fire may schedule more timers, which are due on later ticks
+    template <class Fire>
+    void advance(Fire &&fire) {
+        unsigned slot = current & (SLOTS - 1);
+        // The wheel below has come around: bring the next slot of each level above down
+        for (unsigned level = 1; slot == 0 && level < LEVELS; ++level) {
+            unsigned index = (current >> (SLOT_BITS * level)) & (SLOTS - 1);
+            cascade(level, index);
+            if (index != 0) break;
+        }
+        std::swap(firing, slots[0][slot]);
+        ++current;
+        pending -= firing.size();
+        for (const Timer &timer : firing)
+            fire(timer.payload);
+        firing.clear();
+    }
+
+    // Next tick advance() will run
+    unsigned long long now() const noexcept { return current; }
+    // Timers not yet fired
+    size_t size() const noexcept { return pending; }
+
+    // Drops every pending timer and restarts the wheel at firstTick
+    void reset(unsigned long long firstTick) noexcept {
+        for (auto &level : slots)
+            for (std::vector<Timer> &slot : level)
+                slot.clear();
+        current = firstTick;
+        pending = 0;
+    }
+
+private:
+    struct Timer {
+        unsigned long long due;
+        Payload            payload;
+    };
+    std::vector<Timer> slots[LEVELS][SLOTS];
+    std::vector<Timer> firing; // Timers of the tick being advanced, reused to keep slot capacity
+    unsigned long long current = 1;
+    size_t             pending = 0;
+
+    // Files a timer in the lowest level whose turn reaches its due tick
+    void place(const Timer &timer) {
+        unsigned long long delta = timer.due > current ? timer.due - current : 0;
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= 1ull << (SLOT_BITS * (level + 1)))
+            ++level;
+        unsigned long long due = delta ? timer.due : current; // Overdue timers fire next
+        slots[level][(due >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(timer);
+    }
+
+    void cascade(unsigned level, unsigned index) {
+        std::vector<Timer> timers;
+        std::swap(timers, slots[level][index]);
+        for (const Timer &timer : timers)
+            place(timer);
+        timers.clear();
+        std::swap(timers, slots[level][index]); // Give the slot its capacity back
+    }
+};
@@ -10,7 +10,6 @@
 using json = nlohmann::json;
 template <class T>
 using sptr = std::shared_ptr<T>;
-using e_ptr = sptr<class Entity>;
 
 // Constants
 #define MATH_PI 3.141592653589793238462643383279502884L
@@ -52,7 +51,10 @@ enum CellStateFlags {
     isAgitated      = 0x02, // Cell has waves on its outline
     isRemoved       = 0x04, // Cell was removed from map
     needsUpdate     = 0x08, // Cell needs updating on client side
-    ignoreCollision = 0x10  // Whether or not to ignore collision with self
+    ignoreCollision = 0x10, // Whether or not to ignore collision with self
+    isMoving        = 0x20, // Cell is in map::movingEntities
+    needsReindex    = 0x40, // Cell's bounds changed since the spatial index last saw them
+    justSpawned     = 0x80  // Cell is within its spawn grace period (cannot be eaten by its ejector)
 };
 
 extern unsigned char getFlagFrom(const json::value_type &j);
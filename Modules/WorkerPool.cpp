@@ -0,0 +1,58 @@
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+unsigned WorkerPool::size() const noexcept {
+    return (unsigned)workers.size() + 1;
+}
+
+void WorkerPool::run(unsigned _count, const std::function<void(unsigned)> &_task) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        task  = &_task;
+        count = _count;
+        next  = 0;
+        busy  = (unsigned)workers.size();
+        ++batch;
+    }
+    wake.notify_all();
+    takeTasks();
+
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return busy == 0; });
+    task = nullptr;
+}
+
+void WorkerPool::work() {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || batch != seen; });
+            if (stopping) return;
+            seen = batch;
+        }
+        takeTasks();
+        std::lock_guard<std::mutex> guard(lock);
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
+
+void WorkerPool::takeTasks() {
+    for (unsigned i; (i = next++) < count;)
+        (*task)(i);
+}
@@ -0,0 +1,44 @@
+/***************************************
+Fixed set of threads that work through
+a batch of tasks together with the
+thread that hands the batch out. Tasks
+are taken one at a time, so uneven ones
+balance out across the threads
+***************************************/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class WorkerPool {
+public:
+    // threads counts the calling thread, so threads - 1 are started
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    // Threads a batch is run on, the calling one included
+    unsigned size() const noexcept;
+
+    // Calls task(i) for every i in [0, count), returning once all have returned
+    void run(unsigned count, const std::function<void(unsigned)> &task);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex               lock;
+    std::condition_variable  wake;    // A batch was handed out, or the pool is stopping
+    std::condition_variable  done;    // The last worker finished its part of a batch
+
+    const std::function<void(unsigned)> *task = nullptr;
+    unsigned              count    = 0;
+    std::atomic<unsigned> next{ 0 };  // Next task to be taken
+    unsigned              busy     = 0; // Workers still on the current batch
+    unsigned long long    batch    = 0; // Batches handed out so far
+    bool                  stopping = false;
+
+    void work();
+    void takeTasks();
+};
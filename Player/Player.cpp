@@ -125,7 +125,7 @@ void Player::update() {
 void Player::updateScore() {
     _score = 0;
     double total = 0;
-    for (sptr<PlayerCell::Entity> cell : cells) {
+    for (Entity *cell : cells) {
         _score += cell->mass();
         total += cell->radius();
     }
@@ -136,7 +136,7 @@ void Player::updateCenter() {
     if (cells.empty()) return;
 
     Vec2 avg;
-    for (sptr<PlayerCell::Entity> cell : cells)
+    for (Entity *cell : cells)
         avg += cell->position();
     avg /= (double)cells.size();
 
@@ -151,27 +151,59 @@ void Player::updateViewBox() {
     viewBox.update(_center.x, _center.y, viewPort.x, viewPort.y);
 }
 void Player::updateVisibleNodes() {
-    std::vector<e_ptr> delNodes, eatNodes, addNodes, updNodes;
-    std::map<unsigned int, e_ptr> newVisibleNodes;
+    std::vector<Entity*> eatNodes, addNodes, updNodes;
+    std::vector<unsigned int> delNodes;
+    std::map<unsigned int, Handle> newVisibleNodes;
 
-    for (Collidable *obj : map::quadTree.getObjectsInBound(viewBox)) {
-        if (!obj->data.has_value()) continue;
-        e_ptr entity = std::any_cast<e_ptr>(obj->data);
-        if (visibleNodes.find(entity->nodeId()) == visibleNodes.end()) {
-            addNodes.push_back(entity->shared);
-        } else if (entity->state & needsUpdate) {
-            if (entity.use_count() <= 6)
-                entity->state &= ~needsUpdate;
-            updNodes.push_back(entity->shared);
+    // With the same view as last tick, only what changed since can be new to it
+    unsigned long long since = visibleTick;
+    visibleTick = map::game->tickCount;
+    if (since != 0 && viewBox == visibleBox) {
+        map::quadTree->forEachChangedInBound(viewBox, since, SpatialIndex::anyType, [&](Collidable *obj) {
+            Entity *entity = obj->entity;
+            if (entity == nullptr) return;
+            if (visibleNodes.find(entity->nodeId()) == visibleNodes.end()) {
+                addNodes.push_back(entity);
+                visibleNodes[entity->nodeId()] = entity->handle;
+            } else if (entity->state() & needsUpdate) {
+                updNodes.push_back(entity);
+            }
+        });
+        for (auto it = visibleNodes.begin(); it != visibleNodes.end();) {
+            Entity *entity = map::resolve(it->second); // nullptr if freed while this player was not updated
+            if (entity == nullptr || entity->state() & isRemoved ||
+                (!entity->obj.bound.intersects(viewBox) && entity->creator() != id)) {
+                if (entity != nullptr && entity->killerId())
+                    eatNodes.push_back(entity);
+                delNodes.push_back(it->first);
+                it = visibleNodes.erase(it);
+            } else {
+                ++it;
+            }
         }
-        newVisibleNodes[entity->nodeId()] = entity->shared;
+        if (eatNodes.size() + updNodes.size() + delNodes.size() + addNodes.size() > 0)
+            packetHandler.sendPacket(protocol->updateNodes(eatNodes, updNodes, delNodes, addNodes));
+        return;
     }
-    for (const auto &[nodeId, entity] : visibleNodes) {
-        if (entity->state & isRemoved || 
+    visibleBox = viewBox;
+
+    map::quadTree->forEachInBound(viewBox, [&](Collidable *obj) {
+        Entity *entity = obj->entity;
+        if (entity == nullptr) return;
+        if (visibleNodes.find(entity->nodeId()) == visibleNodes.end()) {
+            addNodes.push_back(entity);
+        } else if (entity->state() & needsUpdate) {
+            updNodes.push_back(entity);
+        }
+        newVisibleNodes[entity->nodeId()] = entity->handle;
+    });
+    for (const auto &[nodeId, handle] : visibleNodes) {
+        Entity *entity = map::resolve(handle);
+        if (entity == nullptr || entity->state() & isRemoved ||
             (newVisibleNodes.find(nodeId) == newVisibleNodes.end() && entity->creator() != id)) {
-            if (entity->killerId())
+            if (entity != nullptr && entity->killerId())
                 eatNodes.push_back(entity);
-            delNodes.push_back(entity);
+            delNodes.push_back(nodeId);
         }
     }
     visibleNodes = newVisibleNodes;
@@ -199,16 +231,16 @@ void Player::onSplit() noexcept {
     if (_state != PlayerState::PLAYING || cells.size() >= cfg::player_maxCells)
         return;
     
-    std::vector<e_ptr> cellsToSplit;
-    for (sptr<PlayerCell::Entity> cell : cells) {
+    std::vector<Entity*> cellsToSplit;
+    for (Entity *cell : cells) {
         // Too small to split
         if (cell->mass() <= cfg::playerCell_minMassToSplit)
             continue;
-        cellsToSplit.push_back(cell->shared);
+        cellsToSplit.push_back(cell);
         if (cellsToSplit.size() + cells.size() >= cfg::player_maxCells)
             break;
     }
-    for (e_ptr cell : cellsToSplit) {
+    for (Entity *cell : cellsToSplit) {
         Vec2 diff = (_mouse - cell->position()).round();
         double angle = 0;
 
@@ -235,7 +267,7 @@ void Player::onEject() noexcept {
     float variation = cfg::playerCell_ejectAngleVariation;
 
     // Eject from all cells if possible
-    for (sptr<PlayerCell::Entity> cell : cells) {
+    for (Entity *cell : cells) {
         if (cell->radius() < cfg::playerCell_minRadiusToEject)
             continue;
 
@@ -256,7 +288,7 @@ void Player::onEject() noexcept {
         // == e * f / 100
         // size = sqrt(e * f / 100 * 100)
         // == sqrt(e * f)
-        sptr<Ejected> ejected = map::spawn<Ejected>(
+        Ejected *ejected = map::spawn<Ejected>(
             cell->position() + diff * cell->radius(), 
             std::sqrt(ejectMass * cfg::ejected_efficiency),
             cell->color()
@@ -272,6 +304,7 @@ void Player::onSpectate() noexcept {
 void Player::onDisconnection() noexcept {
     _state = PlayerState::DISCONNECTED;
     visibleNodes.clear();
+    visibleTick = 0;
     // Should no longer be updated, remove from clients list
     if (owner == nullptr) {
         if (socket == nullptr) {
@@ -290,7 +323,7 @@ void Player::onDisconnection() noexcept {
             server->minions.end(), (Minion*)this));
     }
     // Cache cell destination
-    for (sptr<PlayerCell::Entity> cell : cells)
+    for (Entity *cell : cells)
         cell->mouseCache = cell->position();
     // Remove minions
     while (!minions.empty())
@@ -318,11 +351,11 @@ void Player::spawn() noexcept {
 
     // Chance to spawn from ejected mass
     if (cfg::player_chanceToSpawnFromEjected >= 1 && cfg::player_chanceToSpawnFromEjected <= 100) {
-        std::vector<e_ptr> &ejectedCells = map::entities[Ejected::TYPE];
+        std::vector<Entity*> &ejectedCells = map::entities[Ejected::TYPE];
         if (rand(1, 100) <= cfg::player_chanceToSpawnFromEjected && !ejectedCells.empty()) {
             // Select random ejected cell
-            e_ptr ejected = ejectedCells[rand(0, (int)ejectedCells.size() - 1)];
-            if (ejected && !(ejected->state & isRemoved) && ejected->acceleration() < 1) {
+            Entity *ejected = ejectedCells[rand(0, (int)ejectedCells.size() - 1)];
+            if (!(ejected->state() & isRemoved) && ejected->acceleration() < 1) {
                 position = ejected->position();
                 radius   = std::max(ejected->radius(), radius);
                 color    = ejected->color();
@@ -331,7 +364,8 @@ void Player::spawn() noexcept {
         }
     }
     // Spawn de cell
-    sptr<PlayerCell> cell = map::spawn<PlayerCell>(position, radius, color);
+    PlayerCell *cell = map::spawn<PlayerCell>(position, radius, color);
+    cell->ownerIndex = (unsigned)cells.size();
     cells.push_back(cell);
     cell->setOwner(this);
     cell->setCreator(id);
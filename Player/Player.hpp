@@ -32,7 +32,7 @@ public:
     bool               isForceMerging     = false;
     bool               controllingMinions = false;
     float              spawnRadius        = cfg::playerCell_baseRadius;
-    std::vector<sptr<PlayerCell::Entity>> cells;
+    std::vector<Entity*> cells; // Owned by the map, removed from here as they despawn
     std::vector<Minion*> minions;
 
     // Setters
@@ -83,7 +83,9 @@ private:
     unsigned char lbUpdateTick  = 0;
 
     // Pair entities with their nodeIds
-    std::map<unsigned int, e_ptr> visibleNodes;
+    std::map<unsigned int, Handle> visibleNodes;
+    Rect visibleBox;                   // viewBox visibleNodes was last gathered from in full
+    unsigned long long visibleTick = 0; // Tick visibleNodes was last updated (0 if never)
 
 protected:
     std::string _cellNameUCS2 = "";
@@ -24,29 +24,38 @@ void PlayerBot::update() {
         updateVisibleNodes();
         if (splitCooldown > 0)
             --splitCooldown;
-        decide(*std::max_element(cells.begin(), cells.end(), [](sptr<PlayerCell::Entity> a, sptr<PlayerCell::Entity> b) {
+        decide(*std::max_element(cells.begin(), cells.end(), [](Entity *a, Entity *b) {
             return a->mass() < b->mass();
         }));
     }
 }
 void PlayerBot::updateVisibleNodes() {
     visibleNodes.clear();
-    for (Collidable *obj : map::quadTree.getObjectsInBound(viewBox)) {
-        if (!obj->data.has_value()) continue;
-        e_ptr entity = std::any_cast<e_ptr>(obj->data);
+    auto addVisible = [&](Collidable *obj) {
+        Entity *entity = obj->entity;
         if (entity && entity->owner() != this) 
             visibleNodes.push_back(entity);
-    }
+    };
+    double radius = std::max(viewBox.halfWidth(), viewBox.halfHeight());
+
+    // Everything but food within view
+    map::quadTree->forEachInRadius(_center.x, _center.y, radius, viruses | ejected | mothercells | playercells, addVisible);
+
+    // Only the nearest food, the pull of food further away is negligible
+    nearestFood.clear();
+    map::quadTree->getNearestObjects(_center.x, _center.y, cfg::playerBot_foodTargets, nearestFood, food, radius);
+    for (Collidable *obj : nearestFood)
+        addVisible(obj);
 }
-void PlayerBot::decide(sptr<PlayerCell::Entity> largestCell) {
-    if (!largestCell || largestCell->state & isRemoved)
+void PlayerBot::decide(Entity *largestCell) {
+    if (!largestCell || largestCell->state() & isRemoved)
         return;
     Vec2 result{ 0, 0 };
-    std::vector<e_ptr> threats;
-    e_ptr splitTarget = nullptr;
+    std::vector<Entity*> threats;
+    Entity *splitTarget = nullptr;
     bool isPlayerInViewBox = false;
 
-    for (e_ptr entity : visibleNodes) {
+    for (Entity *entity : visibleNodes) {
         // Get attraction of the cells - avoid larger cells, viruses and same team cells
         float influence = 0.0f;
         if (entity->type == PlayerCell::TYPE) {
@@ -127,7 +136,7 @@ void PlayerBot::decide(sptr<PlayerCell::Entity> largestCell) {
 
     if (splitTarget != nullptr) {
         if (threats.size() > 0) {
-            if (largestCell->radius() > (*std::max_element(threats.begin(), threats.end(), [](e_ptr a, e_ptr b) {
+            if (largestCell->radius() > (*std::max_element(threats.begin(), threats.end(), [](Entity *a, Entity *b) {
                 return a->radius() < b->radius();
             }))->radius() * 1.15) {
                 _mouse = splitTarget->position();
@@ -7,10 +7,11 @@ public:
 
     void update();
     void updateVisibleNodes();
-    void decide(sptr<PlayerCell::Entity> largestCell);
+    void decide(Entity *largestCell);
 
     ~PlayerBot();
 private:
     int splitCooldown = 0;
-    std::vector<e_ptr> visibleNodes;
+    std::vector<Entity*> visibleNodes;
+    std::vector<Collidable*> nearestFood;
 };
\ No newline at end of file
@@ -94,8 +94,8 @@ Buffer &Protocol::updateLeaderboardText(const std::vector<std::string> &board) {
     return buffer;
 }
 // Update these for each protocol
-Buffer &Protocol::updateNodes(const std::vector<e_ptr> &eatNodes, const std::vector<e_ptr> &updNodes,
-    const std::vector<e_ptr> &delNodes, const std::vector<e_ptr> &addNodes) {
+Buffer &Protocol::updateNodes(const std::vector<Entity*> &eatNodes, const std::vector<Entity*> &updNodes,
+    const std::vector<unsigned int> &delNodes, const std::vector<Entity*> &addNodes) {
     return buffer;
 }
 Buffer &Protocol::updateViewport(const Vec2 &position, float scale) {
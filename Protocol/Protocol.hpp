@@ -2,6 +2,7 @@
 #include "../Connection/PacketHandler.hpp"
 
 class Player;
+class Entity;
 class Protocol {
 public:
     Buffer buffer;
@@ -26,8 +27,8 @@ public:
     virtual Buffer &updateLeaderboardList();
     virtual Buffer &updateLeaderboardRGB(const std::vector<float> &board);
     virtual Buffer &updateLeaderboardText(const std::vector<std::string> &board);
-    virtual Buffer &updateNodes(const std::vector<e_ptr> &eatNodes, const std::vector<e_ptr> &updNodes,
-        const std::vector<e_ptr> &delNodes, const std::vector<e_ptr> &addNodes);
+    virtual Buffer &updateNodes(const std::vector<Entity*> &eatNodes, const std::vector<Entity*> &updNodes,
+        const std::vector<unsigned int> &delNodes, const std::vector<Entity*> &addNodes);
     virtual Buffer &updateViewport(const Vec2 &position, float scale);
     virtual Buffer &chatMessage(/**/);
     virtual Buffer &drawLine(const Vec2 &position);
@@ -10,18 +10,18 @@ public:
     virtual Buffer &clearAll() {
         return Protocol::updateNodes({}, {}, {}, {});
     }
-    virtual Buffer &updateNodes(const std::vector<e_ptr> &eatNodes, const std::vector<e_ptr> &updNodes,
-        const std::vector<e_ptr> &delNodes, const std::vector<e_ptr> &addNodes) {
+    virtual Buffer &updateNodes(const std::vector<Entity*> &eatNodes, const std::vector<Entity*> &updNodes,
+        const std::vector<unsigned int> &delNodes, const std::vector<Entity*> &addNodes) {
         buffer.writeUInt8(0x10);
 
         // Eat record
         buffer.writeUInt16_LE((unsigned short)eatNodes.size());
-        for (e_ptr entity : eatNodes) {
+        for (Entity *entity : eatNodes) {
             buffer.writeUInt32_LE(entity->killerId());
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
         }
         // Add record
-        for (e_ptr entity : addNodes) {
+        for (Entity *entity : addNodes) {
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
             buffer.writeInt16_LE((short)entity->position().x);
             buffer.writeInt16_LE((short)entity->position().y);
@@ -33,9 +33,9 @@ public:
 
             unsigned char flags = 0; // extendedFlag
 
-            if (entity->state & isSpiked)
+            if (entity->state() & isSpiked)
                 flags |= 0x01; // has spikes on outline
-            if (entity->state & isAgitated)
+            if (entity->state() & isAgitated)
                 flags |= 0x10;
             if (entity->type == Ejected::TYPE)
                 flags |= 0x20;
@@ -47,7 +47,7 @@ public:
                 buffer.writeUInt16_LE(0);               
         }
         // Update record
-        for (e_ptr entity : updNodes) {
+        for (Entity *entity : updNodes) {
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
             buffer.writeInt16_LE((short)entity->position().x);
             buffer.writeInt16_LE((short)entity->position().y);
@@ -59,9 +59,9 @@ public:
 
             unsigned char flags = 0; // extendedFlag
 
-            if (entity->state & isSpiked)
+            if (entity->state() & isSpiked)
                 flags |= 0x01; // has spikes on outline
-            if (entity->state & isAgitated)
+            if (entity->state() & isAgitated)
                 flags |= 0x10;
             if (entity->type == Ejected::TYPE)
                 flags |= 0x20;
@@ -73,8 +73,8 @@ public:
 
         // Remove record
         buffer.writeUInt32_LE((unsigned)delNodes.size());
-        for (e_ptr entity : delNodes)
-            buffer.writeUInt32_LE((unsigned)entity->nodeId());
+        for (unsigned int nodeId : delNodes)
+            buffer.writeUInt32_LE(nodeId);
         return buffer;
     }
 };
\ No newline at end of file
@@ -20,18 +20,18 @@ public:
         }
         return buffer;
     }
-    virtual Buffer &updateNodes(const std::vector<e_ptr> &eatNodes, const std::vector<e_ptr> &updNodes,
-        const std::vector<e_ptr> &delNodes, const std::vector<e_ptr> &addNodes) {
+    virtual Buffer &updateNodes(const std::vector<Entity*> &eatNodes, const std::vector<Entity*> &updNodes,
+        const std::vector<unsigned int> &delNodes, const std::vector<Entity*> &addNodes) {
         buffer.writeUInt8(0x10);
 
         // Eat record
         buffer.writeUInt16_LE((unsigned short)eatNodes.size());
-        for (e_ptr entity : eatNodes) {
+        for (Entity *entity : eatNodes) {
             buffer.writeUInt32_LE(entity->killerId());
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
         }
         // Add record
-        for (e_ptr entity : addNodes) {
+        for (Entity *entity : addNodes) {
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
             buffer.writeInt32_LE((int)entity->position().x);
             buffer.writeInt32_LE((int)entity->position().y);
@@ -39,7 +39,7 @@ public:
 
             unsigned char flags = 0; // extendedFlag
 
-            if (entity->state & isSpiked)
+            if (entity->state() & isSpiked)
                 flags |= 0x01; // has spikes on outline
             if (true)
                 flags |= 0x02; // has color
@@ -47,7 +47,7 @@ public:
                 if (entity->owner()->skinName() != "") flags |= 0x04;
                 if (entity->owner()->cellNameUTF8() != "") flags |= 0x08;
             }
-            if (entity->state & isAgitated)
+            if (entity->state() & isAgitated)
                 flags |= 0x10;
             if (entity->type == Ejected::TYPE)
                 flags |= 0x20;
@@ -62,7 +62,7 @@ public:
             if (flags & 0x08) buffer.writeStrNull_UTF8(entity->owner()->cellNameUTF8());
         }
         // Update record
-        for (e_ptr entity : updNodes) {
+        for (Entity *entity : updNodes) {
             buffer.writeUInt32_LE((unsigned)entity->nodeId());
             buffer.writeInt32_LE((int)entity->position().x);
             buffer.writeInt32_LE((int)entity->position().y);
@@ -70,11 +70,11 @@ public:
 
             unsigned char flags = 0; // extendedFlag
 
-            if (entity->state & isSpiked)
+            if (entity->state() & isSpiked)
                 flags |= 0x01; // virus
             if (true)
                 flags |= 0x02; // has color
-            if (entity->state & isAgitated)
+            if (entity->state() & isAgitated)
                 flags |= 0x10;
             if (entity->type == Ejected::TYPE)
                 flags |= 0x20;
@@ -90,8 +90,8 @@ public:
 
         // Remove record
         buffer.writeUInt16_LE((unsigned short)delNodes.size());
-        for (e_ptr entity : delNodes)
-            buffer.writeUInt32_LE((unsigned int)entity->nodeId());
+        for (unsigned int nodeId : delNodes)
+            buffer.writeUInt32_LE(nodeId);
         return buffer;
     }
 };
\ No newline at end of file